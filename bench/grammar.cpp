@@ -0,0 +1,74 @@
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include "parser.hpp"
+
+using namespace std;
+using namespace cap;
+
+
+/**************************************************************************
+   Counts the alternatives the parser tries per declaration. With
+   predictive dispatch, every declaration and base type is selected by its
+   first token, so a valid file is parsed without backtracking; the
+   attempts an ordered choice would have wasted are reported as avoided.
+   The counters require building parser.cpp with -DCAP_GRAMMAR_STATISTICS.
+ **************************************************************************/
+
+
+//generate a file with the given number of declarations; typedefs come last in the
+//ordered choice, so they are the worst case for backtracking
+static std::string generate_source(size_t declarations) {
+    std::string result;
+    for (size_t i = 0; i < declarations; ++i) {
+        const std::string n = std::to_string(i);
+        switch (i % 3) {
+            case 0:
+                result += "enum Enum" + n + " {\n    FOO" + n + ",\n    BAR" + n + " = FOO" + n + " + 1\n}\n\n";
+                break;
+            case 1:
+                result += "struct Struct" + n + " {\n    int x;\n    double y;\n    char* name;\n    void* data;\n    Enum" + n + "* values;\n}\n\n";
+                break;
+            case 2:
+                result += "typedef Struct" + n + "* Ptr" + n + "\n\n";
+                break;
+        }
+    }
+    return result;
+}
+
+
+int main(int argc, char* argv[]) {
+    const size_t files = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000;
+    const size_t declarations = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 100;
+    std::string source = generate_source(declarations);
+
+    Diagnostics diagnostics;
+    std::vector<Token> tokens;
+    tokenize(source, tokens, diagnostics);
+
+    grammar_statistics() = GrammarStatistics();
+
+    const auto startTime = std::chrono::steady_clock::now();
+
+    for (size_t i = 0; i < files; ++i) {
+        std::vector<ASTNodePtr> ast;
+        parse(tokens, ast, diagnostics);
+    }
+
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    const GrammarStatistics& statistics = grammar_statistics();
+
+    std::cout << tokens.size() << " tokens, " << declarations << " declarations, " << diagnostics.size() << " diagnostics\n";
+    if (!grammar_statistics_enabled()) {
+        std::cout << "(dispatch counters are not compiled in; build parser.cpp with -DCAP_GRAMMAR_STATISTICS)\n";
+    }
+    std::cout << "dispatches: " << statistics.dispatches / files << "/file\n";
+    std::cout << "misses:     " << statistics.misses / files << "/file (no alternative starts with the token, e.g. at the end of the input)\n";
+    std::cout << "backtracks: " << statistics.backtracks / files << "/file\n";
+    std::cout << "avoided:    " << statistics.avoided / files << "/file\n";
+    std::cout << "parse:      " << seconds * 1e6 / files << " us/file, " << tokens.size() * files / seconds / 1e6 << " Mtokens/s\n";
+
+    return 0;
+}
@@ -0,0 +1,103 @@
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include "pipeline.hpp"
+
+using namespace std;
+using namespace cap;
+
+
+/**************************************************************************
+   Compares the latency of tokenize followed by parse with the pipelined
+   tokenize_and_parse on one large file, and checks that both produce the
+   same tokens, AST and diagnostics.
+ **************************************************************************/
+
+
+//generate a file with the given number of declarations
+static std::string generate_source(size_t declarations) {
+    std::string result;
+    for (size_t i = 0; i < declarations; ++i) {
+        const std::string n = std::to_string(i);
+        switch (i % 3) {
+            case 0:
+                result += "/* enum " + n + " */\nenum Enum" + n + " {\n    FOO" + n + ",\n    BAR" + n + " = FOO" + n + " << 2\n}\n\n";
+                break;
+            case 1:
+                result += "struct Struct" + n + " {\n    int x;\n    char* name; // name\n    Enum" + n + "* data;\n}\n\n";
+                break;
+            case 2:
+                result += "typedef Struct" + n + "* Ptr" + n + "\n\n";
+                break;
+        }
+    }
+    return result;
+}
+
+
+//printed form of a result, for comparison
+static std::string print(const std::vector<Token>& tokens, const std::vector<ASTNodePtr>& ast, const Diagnostics& diagnostics) {
+    std::stringstream stream;
+    for (const Token& token : tokens) {
+        stream << static_cast<int>(token.token) << ' ' << token.position.line << ':' << token.position.column << ' ' << token.content << '\n';
+    }
+    for (const ASTNodePtr& node : ast) {
+        node->print(0, stream);
+    }
+    for (const Diagnostic& diagnostic : diagnostics) {
+        stream << diagnostic.position.line << ':' << diagnostic.position.column << ' ' << diagnostics.format(diagnostic) << '\n';
+    }
+    return stream.str();
+}
+
+
+template <class F> static double measure(size_t runs, F&& f) {
+    const auto startTime = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < runs; ++i) {
+        f();
+    }
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count() * 1e3 / runs;
+}
+
+
+int main(int argc, char* argv[]) {
+    const size_t runs = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 10;
+    const size_t declarations = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 100000;
+    const std::string source = generate_source(declarations);
+
+    std::vector<Token> tokens;
+    std::vector<ASTNodePtr> ast;
+    Diagnostics diagnostics;
+
+    const double lexTime = measure(runs, [&]() {
+        diagnostics.clear();
+        tokenize(source, tokens, diagnostics);
+    });
+
+    const double parseTime = measure(runs, [&]() {
+        parse(tokens, ast, diagnostics);
+    });
+
+    diagnostics.clear();
+    tokenize(source, tokens, diagnostics);
+    parse(tokens, ast, diagnostics);
+    const std::string expected = print(tokens, ast, diagnostics);
+
+    const double pipelineTime = measure(runs, [&]() {
+        diagnostics.clear();
+        tokenize_and_parse(source, tokens, ast, diagnostics);
+    });
+
+    const bool identical = print(tokens, ast, diagnostics) == expected;
+
+    std::cout << source.size() << " bytes, " << tokens.size() << " tokens, " << ast.size() << " declarations\n";
+    std::cout << "tokenize:           " << lexTime << " ms\n";
+    std::cout << "parse:              " << parseTime << " ms\n";
+    std::cout << "tokenize + parse:   " << lexTime + parseTime << " ms\n";
+    std::cout << "tokenize_and_parse: " << pipelineTime << " ms\n";
+    std::cout << "output:             " << (identical ? "identical" : "DIFFERENT") << '\n';
+
+    return identical ? 0 : 1;
+}
@@ -0,0 +1,119 @@
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include "CrossReferenceIndex.hpp"
+#include "parser.hpp"
+
+using namespace std;
+using namespace cap;
+
+
+/**************************************************************************
+   Compares find-references through the cross-reference index with a walk
+   over the ASTs of a project.
+ **************************************************************************/
+
+
+//generate a file; every struct refers to an enum of its own and to a struct of an earlier file
+static std::string generate_source(size_t file, size_t declarations) {
+    std::string result;
+    for (size_t i = 0; i < declarations; ++i) {
+        const std::string n = std::to_string(file) + '_' + std::to_string(i);
+        switch (i % 3) {
+            case 0:
+                result += "enum Enum" + n + " {\n    FOO,\n    BAR\n}\n\n";
+                break;
+            case 1:
+                result += "struct Struct" + n + " {\n    int x;\n    Common* common;\n    Enum" + std::to_string(file) + '_' + std::to_string(i - 1) + " kind;\n}\n\n";
+                break;
+            case 2:
+                result += "typedef Struct" + std::to_string(file) + '_' + std::to_string(i - 1) + "* Ptr" + n + "\n\n";
+                break;
+        }
+    }
+    return result;
+}
+
+
+//does the type refer to the name
+static bool refers_to(const ASTTypename* type, const std::string& name) {
+    if (const auto ptr = dynamic_cast<const ASTTypePtr*>(type)) {
+        return refers_to(ptr->baseType.get(), name);
+    }
+    const auto identifier = dynamic_cast<const ASTTypeIdentifier*>(type);
+    return identifier && identifier->name == name;
+}
+
+
+//count the references by walking the ASTs
+static size_t walk(const std::vector<std::vector<ASTNodePtr>>& asts, const std::string& name) {
+    size_t result = 0;
+    for (const std::vector<ASTNodePtr>& ast : asts) {
+        for (const ASTNodePtr& node : ast) {
+            if (const auto struct_ = dynamic_cast<const ASTStruct*>(node.get())) {
+                for (const auto& member : struct_->members) {
+                    result += refers_to(member->typename_.get(), name);
+                }
+            }
+            else if (const auto typedef_ = dynamic_cast<const ASTTypedef*>(node.get())) {
+                result += refers_to(typedef_->type.get(), name);
+            }
+        }
+    }
+    return result;
+}
+
+
+template <class F> static double measure(size_t runs, F&& f) {
+    const auto startTime = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < runs; ++i) {
+        f();
+    }
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count() * 1e6 / runs;
+}
+
+
+int main(int argc, char* argv[]) {
+    const size_t files = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 100;
+    const size_t declarations = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 1000;
+
+    std::vector<std::string> sources(files);
+    std::vector<std::vector<ASTNodePtr>> asts(files);
+    CrossReferenceIndex index;
+
+    const double buildTime = measure(1, [&]() {
+        FileSymbols symbols;
+        for (size_t file = 0; file < files; ++file) {
+            sources[file] = generate_source(file, declarations);
+            Diagnostics diagnostics;
+            std::vector<Token> tokens;
+            tokenize(sources[file], tokens, diagnostics);
+            symbols.clear();
+            parse(tokens, asts[file], diagnostics, nullptr, &symbols);
+            index.update(static_cast<uint32_t>(file), symbols);
+        }
+    });
+
+    const std::string common = "Common";
+    const std::string local = "Enum" + std::to_string(files / 2) + "_0";
+    const size_t runs = 1000;
+
+    size_t indexed = 0;
+    const double indexCommon = measure(runs, [&]() { indexed = index.references(common).size(); });
+    const double indexLocal = measure(runs, [&]() { indexed += index.references(local).size(); });
+
+    size_t walked = 0;
+    const double walkCommon = measure(10, [&]() { walked = walk(asts, common); });
+    const double walkLocal = measure(10, [&]() { walked += walk(asts, local); });
+
+    std::cout << files * declarations << " declarations in " << files << " files, " << index.size() << " names\n";
+    std::cout << "parse and index:        " << buildTime / 1e3 << " ms\n";
+    std::cout << "index, common name:     " << indexCommon << " us\n";
+    std::cout << "index, local name:      " << indexLocal << " us\n";
+    std::cout << "AST walk, common name:  " << walkCommon << " us\n";
+    std::cout << "AST walk, local name:   " << walkLocal << " us\n";
+    std::cout << "references:             " << indexed << " indexed, " << walked << " walked\n";
+
+    return indexed == walked ? 0 : 1;
+}
@@ -0,0 +1,101 @@
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <string>
+#include "Session.hpp"
+
+using namespace std;
+using namespace cap;
+
+
+/**************************************************************************
+   Counts global heap allocations made by tokenize/parse, with and without
+   a reused Session.
+ **************************************************************************/
+
+
+static size_t allocationCount = 0;
+
+
+void* operator new(size_t size) {
+    ++allocationCount;
+    if (void* p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+
+void operator delete(void* p, size_t) noexcept {
+    std::free(p);
+}
+
+
+//generate a file with the given number of declarations
+static std::string generate_source(size_t declarations) {
+    std::string result;
+    for (size_t i = 0; i < declarations; ++i) {
+        const std::string n = std::to_string(i);
+        switch (i % 3) {
+            case 0:
+                result += "enum Enum" + n + " {\n    FOO" + n + ",\n    BAR" + n + "\n}\n\n";
+                break;
+            case 1:
+                result += "struct Struct" + n + " {\n    int x;\n    char* name;\n    Enum" + n + "* data;\n}\n\n";
+                break;
+            case 2:
+                result += "typedef Struct" + n + "* Ptr" + n + "\n\n";
+                break;
+        }
+    }
+    return result;
+}
+
+
+template <class F> static void measure(const char* name, size_t files, F&& f) {
+    const size_t startCount = allocationCount;
+    const auto startTime = std::chrono::steady_clock::now();
+
+    for (size_t i = 0; i < files; ++i) {
+        f();
+    }
+
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    const size_t count = allocationCount - startCount;
+    std::cout << name << ": " << count / files << " allocations/file, " << seconds * 1e6 / files << " us/file\n";
+}
+
+
+int main(int argc, char* argv[]) {
+    const size_t files = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000;
+    const size_t declarations = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 100;
+    const std::string source = generate_source(declarations);
+
+    measure("without session", files, [&]() {
+        Diagnostics diagnostics;
+        std::string text = source;
+        std::vector<Token> tokens;
+        tokenize(text, tokens, diagnostics);
+        std::vector<ASTNodePtr> ast;
+        parse(tokens, ast, diagnostics);
+    });
+
+    Session session;
+    Diagnostics diagnostics;
+
+    measure("with session", files, [&]() {
+        session.reset();
+        diagnostics.clear();
+        session.source = source;
+        tokenize(session.source, session, diagnostics);
+        parse(session, diagnostics);
+    });
+
+    return 0;
+}
@@ -0,0 +1,87 @@
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include "lexer.hpp"
+#include "unicode.hpp"
+
+using namespace std;
+using namespace cap;
+
+
+/**************************************************************************
+   Measures what UTF-8 validation adds to tokenizing pure-ASCII input.
+   Validation is a separate pass over the input, before lexing, so the
+   tokenize time without it is the tokenize time minus the validation
+   time; both are reported, along with the share of the validation.
+   A UTF-8 input of the same shape is measured for comparison.
+ **************************************************************************/
+
+
+//generate a file with the given number of declarations; non-ASCII text is put in comments and identifiers if requested
+static std::string generate_source(size_t declarations, bool ascii) {
+    const std::string comment = ascii ? "name" : "\xC3\xA9tiquette \xE2\x86\x92 \xF0\x9F\x93\x9D";
+    const std::string suffix = ascii ? "" : "\xC3\xA9";
+    std::string result;
+    for (size_t i = 0; i < declarations; ++i) {
+        const std::string n = std::to_string(i);
+        switch (i % 3) {
+            case 0:
+                result += "/* enum " + n + " */\nenum Enum" + n + suffix + " {\n    FOO" + n + ",\n    BAR" + n + " = FOO" + n + " << 2\n}\n\n";
+                break;
+            case 1:
+                result += "struct Struct" + n + " {\n    int x;\n    char* name; // " + comment + "\n    Enum" + n + suffix + "* data;\n}\n\n";
+                break;
+            case 2:
+                result += "typedef Struct" + n + "* Ptr" + n + "\n\n";
+                break;
+        }
+    }
+    return result;
+}
+
+
+template <class F> static double measure(size_t runs, F&& f) {
+    const auto startTime = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < runs; ++i) {
+        f();
+    }
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count() * 1e3 / runs;
+}
+
+
+//measure and print one input
+static bool run(const char* name, const std::string& source, size_t runs) {
+    std::vector<Token> tokens;
+    Diagnostics diagnostics;
+    bool ascii = false;
+
+    const double validateTime = measure(runs * 10, [&]() {
+        diagnostics.clear();
+        validate_utf8(source, diagnostics, &ascii);
+    });
+
+    const double tokenizeTime = measure(runs, [&]() {
+        diagnostics.clear();
+        tokenize(source, tokens, diagnostics);
+    });
+
+    std::cout << name << ": " << source.size() << " bytes, " << tokens.size() << " tokens, " << (ascii ? "ASCII" : "UTF-8") << '\n';
+    std::cout << "  validation:                  " << validateTime << " ms, " << source.size() / validateTime / 1e3 << " MB/s\n";
+    std::cout << "  tokenize:                    " << tokenizeTime << " ms\n";
+    std::cout << "  tokenize without validation: " << tokenizeTime - validateTime << " ms\n";
+    std::cout << "  validation share:            " << validateTime * 100 / tokenizeTime << "%\n";
+
+    return diagnostics.empty();
+}
+
+
+int main(int argc, char* argv[]) {
+    const size_t runs = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 10;
+    const size_t declarations = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 100000;
+
+    const bool asciiOk = run("ascii", generate_source(declarations, true), runs);
+    const bool utf8Ok = run("utf-8", generate_source(declarations, false), runs);
+
+    return asciiOk && utf8Ok ? 0 : 1;
+}
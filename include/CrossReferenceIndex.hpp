@@ -0,0 +1,180 @@
+#ifndef CAP_CROSSREFERENCEINDEX_HPP
+#define CAP_CROSSREFERENCEINDEX_HPP
+
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "Position.hpp"
+
+
+namespace cap {
+
+
+    /**
+     * Location in a project.
+     */
+    struct Location {
+        //file id; for builds, the index of the file in the build's file list.
+        uint32_t file;
+
+        //position in the file.
+        Position position;
+
+        bool operator == (const Location& other) const {
+            return file == other.file && position == other.position;
+        }
+
+        bool operator != (const Location& other) const {
+            return !(*this == other);
+        }
+
+        bool operator < (const Location& other) const {
+            return file < other.file || (file == other.file && position < other.position);
+        }
+    };
+
+
+    /**
+     * Definitions and references of type names in one file, collected while it is parsed.
+     * Structs, enums and typedefs define names; identifier types refer to them.
+     * Names are copied into one text buffer, so they outlive the source, and
+     * collecting them does not allocate per name.
+     */
+    class FileSymbols {
+    public:
+        /**
+         * Records the definition of a name.
+         * @param name name.
+         * @param position position of the name in the definition.
+         */
+        void define(std::string_view name, const Position& position) {
+            add(name, position, true);
+        }
+
+        /**
+         * Records a reference to a name.
+         * @param name name.
+         * @param position position of the reference.
+         */
+        void reference(std::string_view name, const Position& position) {
+            add(name, position, false);
+        }
+
+        /**
+         * Returns the number of definitions and references.
+         */
+        size_t size() const {
+            return m_records.size();
+        }
+
+        /**
+         * Removes all definitions and references; the buffers keep their capacity.
+         */
+        void clear() {
+            m_records.clear();
+            m_text.clear();
+        }
+
+    private:
+        struct Record {
+            uint32_t offset;
+            uint32_t length;
+            Position position;
+            bool definition;
+        };
+
+        std::vector<Record> m_records;
+        std::string m_text;
+
+        void add(std::string_view name, const Position& position, bool definition) {
+            m_records.push_back(Record{ static_cast<uint32_t>(m_text.size()), static_cast<uint32_t>(name.size()), position, definition });
+            m_text += name;
+        }
+
+        friend class CrossReferenceIndex;
+    };
+
+
+    /**
+     * Index from type names to their definitions and references across files.
+     * Each name keeps its definitions and references in sorted vectors of locations.
+     * Lookups take O(log n) in the number of names, and so does finding the
+     * references of a name from a single file. Files are updated independently.
+     * The index keeps iterators into its own map, so it can be moved but not copied.
+     */
+    class CrossReferenceIndex {
+    public:
+        CrossReferenceIndex() = default;
+        CrossReferenceIndex(const CrossReferenceIndex&) = delete;
+        CrossReferenceIndex(CrossReferenceIndex&&) = default;
+        CrossReferenceIndex& operator = (const CrossReferenceIndex&) = delete;
+        CrossReferenceIndex& operator = (CrossReferenceIndex&&) = default;
+
+        /**
+         * Locations of one name, sorted by file and position.
+         */
+        struct Symbol {
+            std::vector<Location> definitions;
+            std::vector<Location> references;
+        };
+
+        /**
+         * Replaces the definitions and references of a file.
+         * @param file file id.
+         * @param symbols the definitions and references of the file.
+         */
+        void update(uint32_t file, const FileSymbols& symbols);
+
+        /**
+         * Removes the definitions and references of a file.
+         * @param file file id.
+         */
+        void remove(uint32_t file);
+
+        /**
+         * Returns the locations of a name, or null if the name is neither defined nor referenced.
+         */
+        const Symbol* find(std::string_view name) const;
+
+        /**
+         * Returns the first definition of a name, or null if there is none.
+         */
+        const Location* definition(std::string_view name) const;
+
+        /**
+         * Returns the references to a name, sorted by file and position.
+         */
+        const std::vector<Location>& references(std::string_view name) const;
+
+        /**
+         * Returns the number of indexed names.
+         */
+        size_t size() const {
+            return m_symbols.size();
+        }
+
+        /**
+         * Removes all files.
+         */
+        void clear() {
+            m_symbols.clear();
+            m_files.clear();
+        }
+
+    private:
+        using SymbolMap = std::map<std::string, Symbol, std::less<>>;
+
+        SymbolMap m_symbols;
+
+        //the symbols each file has locations in, indexed by file id
+        std::vector<std::vector<SymbolMap::iterator>> m_files;
+    };
+
+
+} //namespace cap
+
+
+#endif //CAP_CROSSREFERENCEINDEX_HPP
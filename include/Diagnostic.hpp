@@ -0,0 +1,253 @@
+#ifndef CAP_DIAGNOSTIC_HPP
+#define CAP_DIAGNOSTIC_HPP
+
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+#include "Error.hpp"
+
+
+namespace cap {
+
+
+    /**
+     * Diagnostic ids; each id maps to a message template.
+     */
+    enum class DIAGNOSTIC : uint16_t {
+        //"syntax error"
+        SYNTAX_ERROR,
+
+        //"Expected {0}"
+        EXPECTED,
+
+        //"Invalid declaration"
+        INVALID_DECLARATION,
+
+        //"cannot read file"
+        CANNOT_READ_FILE,
+
+        //"{0}"
+        INTERNAL_ERROR,
+
+        //"invalid UTF-8 sequence"
+        INVALID_UTF8,
+
+        //"invalid character {0} in identifier"
+        INVALID_IDENTIFIER_CHARACTER,
+
+        //"integer literal {0} is too large"
+        INTEGER_TOO_LARGE,
+
+        //"division by zero"
+        DIVISION_BY_ZERO,
+
+        //"invalid shift count"
+        INVALID_SHIFT,
+
+        //"value of {0} is not an integer constant"
+        NOT_CONSTANT,
+
+        //"cannot import {0}"
+        CANNOT_IMPORT,
+
+        //"import cycle: {0}"
+        IMPORT_CYCLE,
+
+        //"expression is nested more than {0} levels deep"
+        EXPRESSION_TOO_DEEP,
+
+        //"redefinition of constant {0}"
+        CONSTANT_REDEFINED,
+
+        //number of diagnostic ids; not a diagnostic.
+        COUNT
+    };
+
+
+    /**
+     * Compact diagnostic record.
+     * The message is not formatted until it is rendered;
+     * the arguments are kept as slices of the owning Diagnostics' text buffer.
+     */
+    struct Diagnostic {
+        //maximum number of arguments.
+        static constexpr size_t MAX_ARGUMENTS = 2;
+
+        //argument slice.
+        struct Argument {
+            uint32_t offset;
+            uint32_t length;
+        };
+
+        //id.
+        DIAGNOSTIC id;
+
+        //index of the file the diagnostic belongs to.
+        uint32_t file;
+
+        //position into the original text.
+        Position position;
+
+        //arguments.
+        Argument arguments[MAX_ARGUMENTS];
+    };
+
+
+    /**
+     * A bounded, deduplicating collection of diagnostics.
+     */
+    class Diagnostics {
+    public:
+        //default per-file limit.
+        static constexpr size_t DEFAULT_LIMIT = 100;
+
+        //no limit.
+        static constexpr size_t UNLIMITED = SIZE_MAX;
+
+        /**
+         * Constructor.
+         * @param limit maximum number of diagnostics kept; further ones are counted as dropped.
+         * @param file index of the file the reported diagnostics belong to.
+         */
+        explicit Diagnostics(size_t limit = DEFAULT_LIMIT, uint32_t file = 0);
+
+        Diagnostics(const Diagnostics& other);
+        Diagnostics(Diagnostics&& other);
+        Diagnostics& operator = (const Diagnostics& other);
+        Diagnostics& operator = (Diagnostics&& other);
+
+        /**
+         * Reports a diagnostic.
+         * Identical diagnostics are kept once; diagnostics over the limit are dropped.
+         * The arguments are copied, so they need not outlive the call.
+         * @return true if the diagnostic was recorded.
+         */
+        bool report(DIAGNOSTIC id, const Position& position, std::string_view argument0 = {}, std::string_view argument1 = {});
+
+        /**
+         * Appends the diagnostics of another collection, bypassing the limit.
+         * Diagnostics identical to recorded ones are counted as duplicates, as in report.
+         */
+        void append(const Diagnostics& other);
+
+        /**
+         * Reports the diagnostics of another collection, in order, as belonging to this collection's file;
+         * they are subject to the limit and deduplication of this collection.
+         * The diagnostics the other collection dropped or found duplicate are counted here as such too.
+         */
+        void transfer(const Diagnostics& other);
+
+        /**
+         * Stable-sorts the diagnostics.
+         * @param less comparison of two records.
+         */
+        template <class Less> void sort(Less&& less) {
+            std::stable_sort(m_records.begin(), m_records.end(), less);
+            reindex();
+        }
+
+        /**
+         * Returns the text of an argument.
+         */
+        std::string_view argument(const Diagnostic& diagnostic, size_t index) const {
+            const Diagnostic::Argument& argument = diagnostic.arguments[index];
+            return std::string_view(m_text).substr(argument.offset, argument.length);
+        }
+
+        /**
+         * Formats the message of the given diagnostic.
+         */
+        std::string format(const Diagnostic& diagnostic) const;
+
+        /**
+         * Renders all diagnostics as errors.
+         */
+        void render(std::vector<Error>& errors) const;
+
+        /**
+         * Removes all diagnostics.
+         */
+        void clear();
+
+        const std::vector<Diagnostic>& records() const {
+            return m_records;
+        }
+
+        std::vector<Diagnostic>::const_iterator begin() const {
+            return m_records.begin();
+        }
+
+        std::vector<Diagnostic>::const_iterator end() const {
+            return m_records.end();
+        }
+
+        size_t size() const {
+            return m_records.size();
+        }
+
+        bool empty() const {
+            return m_records.empty();
+        }
+
+        //true if no more diagnostics can be recorded.
+        bool full() const {
+            return m_records.size() >= m_limit;
+        }
+
+        //number of diagnostics dropped due to the limit.
+        size_t dropped() const {
+            return m_dropped;
+        }
+
+        //number of duplicate diagnostics not recorded.
+        size_t duplicates() const {
+            return m_duplicates;
+        }
+
+        size_t limit() const {
+            return m_limit;
+        }
+
+        uint32_t file() const {
+            return m_file;
+        }
+
+        //bytes held by the records, their argument text and the deduplication index;
+        //the index is estimated from its bucket and element counts.
+        size_t memory_usage() const {
+            return m_records.capacity() * sizeof(Diagnostic) + (m_text.empty() ? 0 : m_text.capacity()) +
+                (m_index.empty() ? 0 : m_index.bucket_count() * sizeof(void*) + m_index.size() * INDEX_NODE_SIZE);
+        }
+
+    private:
+        //hashes/compares record indexes by record content, for deduplication.
+        struct Key {
+            const Diagnostics* diagnostics;
+            size_t operator ()(uint32_t index) const;
+            bool operator ()(uint32_t a, uint32_t b) const;
+        };
+
+        //size of an index node: the next pointer, the record index and the cached hash.
+        static constexpr size_t INDEX_NODE_SIZE = sizeof(void*) + sizeof(size_t) + sizeof(size_t);
+
+        size_t m_limit;
+        uint32_t m_file;
+        size_t m_dropped{ 0 };
+        size_t m_duplicates{ 0 };
+        std::vector<Diagnostic> m_records;
+        std::string m_text;
+        std::unordered_set<uint32_t, Key, Key> m_index;
+
+        Diagnostic::Argument store(std::string_view text);
+        void reindex();
+    };
+
+
+} //namespace cap
+
+
+#endif //CAP_DIAGNOSTIC_HPP
@@ -0,0 +1,151 @@
+#ifndef CAP_MEMORYSTATISTICS_HPP
+#define CAP_MEMORYSTATISTICS_HPP
+
+
+#include <algorithm>
+#include <cstddef>
+#include <ostream>
+#include <vector>
+
+
+namespace cap {
+
+
+    enum class AST;
+
+
+    /**
+     * Front-end phases memory is attributed to.
+     */
+    enum class PHASE {
+        //source text.
+        SOURCE,
+
+        //the std::vector<Token> produced by the lexer.
+        TOKENS,
+
+        //the parserlib match lists of the lexer and of the parser.
+        MATCHES,
+
+        //AST node allocations; further broken down by AST kind.
+        AST,
+
+        //diagnostic records and their argument text.
+        DIAGNOSTICS
+    };
+
+
+    /**
+     * Memory counter of a phase.
+     */
+    struct MemoryCounter {
+        //total bytes allocated.
+        size_t bytes = 0;
+
+        //number of allocations.
+        size_t allocations = 0;
+
+        //bytes currently allocated.
+        size_t current = 0;
+
+        //maximum of current.
+        size_t peak = 0;
+
+        void allocate(size_t size, size_t count = 1) {
+            bytes += size;
+            allocations += count;
+            current += size;
+            peak = std::max(peak, current);
+        }
+
+        void deallocate(size_t size) {
+            current -= std::min(current, size);
+        }
+
+        //records a buffer changing capacity from oldSize to newSize bytes.
+        void reallocate(size_t oldSize, size_t newSize) {
+            if (newSize != oldSize) {
+                if (newSize > 0) {
+                    allocate(newSize);
+                }
+                deallocate(oldSize);
+            }
+        }
+
+        //adds the counters of another, concurrently running, owner.
+        void merge(const MemoryCounter& other) {
+            bytes += other.bytes;
+            allocations += other.allocations;
+            current += other.current;
+            peak += other.peak;
+        }
+    };
+
+
+    /**
+     * Opt-in memory accounting of the front-end.
+     * Vectors are accounted by capacity, AST nodes by the exact size of their own allocation.
+     * The heap storage of the strings and member vectors inside AST nodes is not accounted.
+     */
+    class MemoryStatistics {
+    public:
+        //number of phases.
+        static constexpr size_t PHASE_COUNT = static_cast<size_t>(PHASE::DIAGNOSTICS) + 1;
+
+        //number of tokens produced.
+        size_t tokens = 0;
+
+        //number of AST nodes created.
+        size_t astNodes = 0;
+
+        MemoryCounter& operator [](PHASE phase) {
+            return m_phases[static_cast<size_t>(phase)];
+        }
+
+        const MemoryCounter& operator [](PHASE phase) const {
+            return m_phases[static_cast<size_t>(phase)];
+        }
+
+        /**
+         * Returns the counter of an AST kind.
+         */
+        MemoryCounter& ast(AST kind);
+
+        /**
+         * Returns the counters of all AST kinds, indexed by AST.
+         */
+        const std::vector<MemoryCounter>& ast() const {
+            return m_ast;
+        }
+
+        /**
+         * Releases the AST memory of the current file; called by the owner of the AST once it has destroyed it.
+         */
+        void release_ast();
+
+        /**
+         * Adds the statistics of another, concurrently running, owner.
+         */
+        void merge(const MemoryStatistics& other);
+
+        //bytes allocated by all phases per token.
+        double bytes_per_token() const;
+
+        //AST bytes per AST node.
+        double bytes_per_ast_node() const;
+
+        /**
+         * Prints a report.
+         */
+        void print(std::basic_ostream<char>& stream) const;
+
+    private:
+        MemoryCounter m_phases[PHASE_COUNT];
+        std::vector<MemoryCounter> m_ast;
+    };
+
+
+} //namespace cap
+
+
+#endif //CAP_MEMORYSTATISTICS_HPP
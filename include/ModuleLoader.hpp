@@ -0,0 +1,170 @@
+#ifndef CAP_MODULELOADER_HPP
+#define CAP_MODULELOADER_HPP
+
+
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "CrossReferenceIndex.hpp"
+#include "file.hpp"
+#include "parser.hpp"
+
+
+namespace cap {
+
+
+    /**
+     * Parsed content of a module; shared by all modules with the same content.
+     */
+    struct ModuleContent {
+        //FNV-1a hash of the source.
+        uint64_t hash = 0;
+
+        //source text.
+        std::string source;
+
+        //declarations.
+        std::vector<ASTNodePtr> ast;
+
+        //lexer and parser diagnostics, limited as set for the loader; their file id is 0.
+        Diagnostics diagnostics;
+
+        //type name definitions and references.
+        FileSymbols symbols;
+    };
+
+
+    /**
+     * A loaded module. Modules are immutable once loaded, so they are shared
+     * read-only by every importer, on every thread.
+     */
+    struct Module {
+        //canonical path.
+        std::string path;
+
+        //canonical paths of the imported modules, in declaration order.
+        std::vector<std::string> imports;
+
+        //parsed content; null for modules that are parsed elsewhere (see ModuleLoader::seed).
+        std::shared_ptr<const ModuleContent> content;
+    };
+
+
+    /**
+     * An import declaration of a file.
+     */
+    struct ModuleImport {
+        //canonical path of the imported file.
+        std::string path;
+
+        //position of the import declaration.
+        Position position;
+    };
+
+
+    /**
+     * Loads modules, parsing each one once per loader.
+     * Modules are cached under their canonical path. Their content is cached under its hash,
+     * so copies of a file at different paths are parsed once too.
+     * All functions are thread-safe. Loading a module never waits for the modules it imports,
+     * so threads that load modules importing each other cannot deadlock.
+     * The declarations of a module are not visible to its importers; e.g. their enum
+     * initializers cannot name the enum constants of the modules they import.
+     * The memory of a module is accounted in the statistics of the request that parses it;
+     * its source, AST and diagnostics remain current for as long as the loader keeps them.
+     */
+    class ModuleLoader {
+    public:
+        /**
+         * Constructor.
+         * @param diagnosticLimit maximum number of diagnostics kept per module.
+         */
+        explicit ModuleLoader(size_t diagnosticLimit = Diagnostics::DEFAULT_LIMIT);
+
+        /**
+         * Returns the module of a file, reading and parsing it on first use.
+         * Concurrent requests for a module that is being loaded wait for it.
+         * @param path path of the file.
+         * @param statistics optional memory accounting, if the module is parsed.
+         * @return the module, or null if the file cannot be read or parsed.
+         */
+        std::shared_ptr<const Module> module(const std::string& path, MemoryStatistics* statistics = nullptr);
+
+        /**
+         * Registers a file that is parsed elsewhere, e.g. an input file of a build,
+         * so that importing it does not parse it again. Its module has no content;
+         * it replaces any module of the file loaded before, until it is forgotten.
+         * @param path path of the file.
+         * @param imports the import declarations of the file.
+         */
+        void seed(const std::string& path, const std::vector<ModuleImport>& imports);
+
+        /**
+         * Forgets the module of a file, e.g. a seeded one once the build it belongs to is over;
+         * the file is loaded again on its next use.
+         * @param path path of the file.
+         */
+        void forget(const std::string& path);
+
+        /**
+         * Loads the modules imported, directly or indirectly, by a file.
+         * Errors are reported at the import declaration of the file that leads to them.
+         * @param path path of the importing file.
+         * @param imports the import declarations of the importing file.
+         * @param diagnostics diagnostics of the importing file.
+         * @param statistics optional memory accounting of the modules parsed.
+         * @return the imported modules, each once, every module after the modules it imports.
+         */
+        std::vector<std::shared_ptr<const Module>> load_imports(const std::string& path, const std::vector<ModuleImport>& imports, Diagnostics& diagnostics, MemoryStatistics* statistics = nullptr);
+
+        /**
+         * Loads the modules imported, directly or indirectly, by a file.
+         * @param path path of the importing file.
+         * @param declarations declarations of the importing file.
+         * @param diagnostics diagnostics of the importing file.
+         * @param statistics optional memory accounting of the modules parsed.
+         * @return the imported modules, each once, every module after the modules it imports.
+         */
+        std::vector<std::shared_ptr<const Module>> load_imports(const std::string& path, const std::vector<ASTNodePtr>& declarations, Diagnostics& diagnostics, MemoryStatistics* statistics = nullptr);
+
+        /**
+         * Returns the number of modules requested so far, including unreadable ones.
+         */
+        size_t size() const;
+
+    private:
+        using ModuleFuture = std::shared_future<std::shared_ptr<const Module>>;
+        using ContentFuture = std::shared_future<std::shared_ptr<const ModuleContent>>;
+
+        //a content entry is published before it is parsed, so that a copy waits for the parse
+        struct ContentEntry {
+            std::shared_ptr<const ModuleContent> content;
+            ContentFuture parsed;
+        };
+
+        size_t m_diagnosticLimit;
+        mutable std::mutex m_mutex;
+        std::unordered_map<std::string, ModuleFuture> m_modules;
+        std::unordered_multimap<uint64_t, ContentEntry> m_contents;
+
+        std::shared_ptr<const Module> load(const std::string& path, MemoryStatistics* statistics);
+        std::shared_ptr<const ModuleContent> share(std::shared_ptr<ModuleContent> content, MemoryStatistics* statistics);
+    };
+
+
+    /**
+     * Returns the import declarations among the declarations of a file.
+     * @param path path of the file; relative import paths are resolved against its directory.
+     * @param declarations declarations of the file.
+     */
+    std::vector<ModuleImport> resolve_imports(const std::string& path, const std::vector<ASTNodePtr>& declarations);
+
+
+} //namespace cap
+
+
+#endif //CAP_MODULELOADER_HPP
@@ -0,0 +1,92 @@
+#ifndef CAP_NODEALLOCATOR_HPP
+#define CAP_NODEALLOCATOR_HPP
+
+
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+
+
+namespace cap {
+
+
+    /**
+     * Counts of the allocations made through node allocators.
+     */
+    struct AllocationCounter {
+        //total bytes allocated.
+        size_t bytes = 0;
+
+        //number of allocations.
+        size_t allocations = 0;
+    };
+
+
+    /**
+     * Allocator of AST nodes.
+     * Nodes are allocated from a memory resource; when a counter is given, the allocations are counted on their way.
+     * Each node keeps a copy of the allocator for its deallocation, which does not touch the counter,
+     * so the counter only has to outlive parsing, while the resource has to outlive the nodes.
+     */
+    template <class T> class NodeAllocator {
+    public:
+        using value_type = T;
+
+        NodeAllocator(std::pmr::memory_resource* resource, AllocationCounter* counter = nullptr)
+            : m_resource(resource)
+            , m_counter(counter)
+        {
+        }
+
+        template <class U> NodeAllocator(const NodeAllocator<U>& other)
+            : m_resource(other.resource())
+            , m_counter(other.counter())
+        {
+        }
+
+        T* allocate(size_t count) {
+            if (m_counter) {
+                m_counter->bytes += count * sizeof(T);
+                ++m_counter->allocations;
+            }
+            return static_cast<T*>(m_resource->allocate(count * sizeof(T), alignof(T)));
+        }
+
+        void deallocate(T* p, size_t count) {
+            m_resource->deallocate(p, count * sizeof(T), alignof(T));
+        }
+
+        std::pmr::memory_resource* resource() const {
+            return m_resource;
+        }
+
+        AllocationCounter* counter() const {
+            return m_counter;
+        }
+
+        template <class U> bool operator == (const NodeAllocator<U>& other) const {
+            return m_resource == other.resource();
+        }
+
+        template <class U> bool operator != (const NodeAllocator<U>& other) const {
+            return m_resource != other.resource();
+        }
+
+    private:
+        std::pmr::memory_resource* m_resource;
+        AllocationCounter* m_counter;
+    };
+
+
+    /**
+     * Creates a node with the given allocator.
+     */
+    template <class T, class U> std::shared_ptr<T> allocate_node(const NodeAllocator<U>& allocator) {
+        return std::allocate_shared<T>(NodeAllocator<T>(allocator));
+    }
+
+
+} //namespace cap
+
+
+#endif //CAP_NODEALLOCATOR_HPP
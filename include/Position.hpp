@@ -8,6 +8,18 @@ namespace cap {
     struct Position {
         int line;
         int column;
+
+        bool operator == (const Position& other) const {
+            return line == other.line && column == other.column;
+        }
+
+        bool operator != (const Position& other) const {
+            return !(*this == other);
+        }
+
+        bool operator < (const Position& other) const {
+            return line < other.line || (line == other.line && column < other.column);
+        }
     };
 
 
@@ -0,0 +1,150 @@
+#ifndef CAP_RINGBUFFER_HPP
+#define CAP_RINGBUFFER_HPP
+
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+
+namespace cap {
+
+
+    /**
+     * Lock-free bounded queue for exactly one producer thread and one consumer thread.
+     * Each index is written by one side only; an acquire load of the other side's index
+     * makes the slots it published visible. Blocking operations spin, then yield, then sleep
+     * on a condition variable; the other side takes the mutex only when someone sleeps.
+     * @param T item type; it must be default-constructible and movable.
+     * @param CAPACITY number of slots; a power of two.
+     */
+    template <class T, size_t CAPACITY> class RingBuffer {
+    public:
+        static_assert(CAPACITY > 0 && (CAPACITY & (CAPACITY - 1)) == 0, "capacity must be a power of two");
+
+        /**
+         * Adds an item, unless the buffer is full.
+         * Producer only.
+         * @param item item; moved from on success.
+         * @return true if the item was added.
+         */
+        bool try_push(T& item) {
+            const size_t tail = m_tail.load(std::memory_order_relaxed);
+            if (tail - m_head.load(std::memory_order_acquire) == CAPACITY) {
+                return false;
+            }
+            m_slots[tail & (CAPACITY - 1)] = std::move(item);
+            m_tail.store(tail + 1, std::memory_order_release);
+            wake();
+            return true;
+        }
+
+        /**
+         * Adds an item, waiting while the buffer is full.
+         * Producer only.
+         * @param item item.
+         */
+        void push(T item) {
+            for (size_t spins = 0; !try_push(item); ++spins) {
+                if (spins == SLEEP_SPINS) {
+                    sleep([this]() { return m_tail.load(std::memory_order_relaxed) - m_head.load(std::memory_order_acquire) != CAPACITY; });
+                    spins = 0;
+                }
+                backoff(spins);
+            }
+        }
+
+        /**
+         * Removes the oldest item, unless the buffer is empty.
+         * Consumer only.
+         * @param item output.
+         * @return true if an item was removed.
+         */
+        bool try_pop(T& item) {
+            const size_t head = m_head.load(std::memory_order_relaxed);
+            if (head == m_tail.load(std::memory_order_acquire)) {
+                return false;
+            }
+            item = std::move(m_slots[head & (CAPACITY - 1)]);
+            m_head.store(head + 1, std::memory_order_release);
+            wake();
+            return true;
+        }
+
+        /**
+         * Removes the oldest item, waiting while the buffer is empty and not closed.
+         * Consumer only.
+         * @param item output.
+         * @return false if the buffer is closed and drained.
+         */
+        bool pop(T& item) {
+            for (size_t spins = 0; !try_pop(item); ++spins) {
+                if (m_closed.load(std::memory_order_acquire)) {
+                    //items pushed before close are visible now
+                    return try_pop(item);
+                }
+                if (spins == SLEEP_SPINS) {
+                    sleep([this]() { return m_head.load(std::memory_order_relaxed) != m_tail.load(std::memory_order_acquire) || m_closed.load(std::memory_order_acquire); });
+                    spins = 0;
+                }
+                backoff(spins);
+            }
+            return true;
+        }
+
+        /**
+         * Signals that no more items will be pushed.
+         * Producer only.
+         */
+        void close() {
+            m_closed.store(true, std::memory_order_release);
+            wake();
+        }
+
+    private:
+        //spins before yielding, and before sleeping.
+        static constexpr size_t YIELD_SPINS = 64;
+        static constexpr size_t SLEEP_SPINS = 256;
+
+        //the indexes are written by different threads, so they live on different cache lines
+        alignas(64) std::atomic<size_t> m_head{ 0 };
+        alignas(64) std::atomic<size_t> m_tail{ 0 };
+        alignas(64) std::atomic<bool> m_closed{ false };
+        std::atomic<size_t> m_sleepers{ 0 };
+        std::mutex m_mutex;
+        std::condition_variable m_wakeup;
+        std::array<T, CAPACITY> m_slots;
+
+        static void backoff(size_t spins) {
+            if (spins >= YIELD_SPINS) {
+                std::this_thread::yield();
+            }
+        }
+
+        //both sides update the sleeper count with read-modify-writes, which are totally ordered:
+        //either the waker's comes later and sees the sleeper, or the sleeper's comes later and
+        //acquires the waker's update of the indexes before checking the condition
+        template <class Ready> void sleep(Ready&& ready) {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_sleepers.fetch_add(1, std::memory_order_acq_rel);
+            m_wakeup.wait(lock, ready);
+            m_sleepers.fetch_sub(1, std::memory_order_relaxed);
+        }
+
+        void wake() {
+            if (m_sleepers.fetch_add(0, std::memory_order_acq_rel) > 0) {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_wakeup.notify_all();
+            }
+        }
+    };
+
+
+} //namespace cap
+
+
+#endif //CAP_RINGBUFFER_HPP
@@ -0,0 +1,108 @@
+#ifndef CAP_SESSION_HPP
+#define CAP_SESSION_HPP
+
+
+#include <cstddef>
+#include <memory_resource>
+#include <optional>
+#include <string>
+#include <vector>
+#include "parser.hpp"
+
+
+namespace cap {
+
+
+    /**
+     * Reusable compilation session.
+     * A worker that processes many files keeps one session and resets it between files:
+     * the source, token and AST vectors keep their capacity, and AST nodes are carved
+     * out of a monotonic arena that is released in one step.
+     */
+    class Session {
+    public:
+        //default initial arena size.
+        static constexpr size_t DEFAULT_ARENA_SIZE = 64 * 1024;
+
+        //source text of the current file; tokens refer into it.
+        std::string source;
+
+        //tokens of the current file.
+        std::vector<Token> tokens;
+
+        //AST of the current file; the nodes live in the session arena.
+        std::vector<ASTNodePtr> ast;
+
+        //optional memory accounting of the files processed with this session.
+        MemoryStatistics* statistics = nullptr;
+
+        //optional collection of the type name definitions and references of the current file.
+        FileSymbols* symbols = nullptr;
+
+        /**
+         * Constructor.
+         * @param arenaSize initial size of the arena; it grows to fit the largest file seen.
+         */
+        explicit Session(size_t arenaSize = DEFAULT_ARENA_SIZE);
+
+        /**
+         * Destroys the AST before the arena its nodes live in.
+         */
+        ~Session();
+
+        Session(const Session&) = delete;
+        Session& operator = (const Session&) = delete;
+
+        /**
+         * Returns the per-file memory resource.
+         */
+        std::pmr::memory_resource* resource() {
+            return &*m_arena;
+        }
+
+        /**
+         * Releases all per-file memory at once.
+         * The AST is cleared first; nodes retained outside of the session become invalid.
+         * The source and token buffers are kept, so they are not accounted as released.
+         */
+        void reset();
+
+    private:
+        //upstream of the arena; records how much the arena spilled over its buffer.
+        class Upstream : public std::pmr::memory_resource {
+        public:
+            size_t allocated = 0;
+
+        private:
+            void* do_allocate(size_t bytes, size_t alignment) override;
+            void do_deallocate(void* p, size_t bytes, size_t alignment) override;
+            bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+        };
+
+        Upstream m_upstream;
+        std::vector<std::byte> m_buffer;
+        std::optional<std::pmr::monotonic_buffer_resource> m_arena;
+    };
+
+
+    /**
+     * Tokenizes the input into the session's tokens.
+     * @param input input; it must outlive the tokens (normally, it is the session's source).
+     * @param session session.
+     * @param diagnostics diagnostics.
+     */
+    void tokenize(const std::string& input, Session& session, Diagnostics& diagnostics);
+
+
+    /**
+     * Parses the session's tokens into the session's AST.
+     * @param session session.
+     * @param diagnostics diagnostics.
+     */
+    void parse(Session& session, Diagnostics& diagnostics);
+
+
+} //namespace cap
+
+
+#endif //CAP_SESSION_HPP
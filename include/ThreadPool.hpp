@@ -0,0 +1,97 @@
+#ifndef CAP_THREADPOOL_HPP
+#define CAP_THREADPOOL_HPP
+
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+namespace cap {
+
+
+    /**
+     * Work-stealing thread pool.
+     * Each worker owns a task deque; it runs its own tasks in submission order, from the front,
+     * and, when it runs dry, steals the oldest task of another worker, so that tasks submitted
+     * first start first across the whole pool.
+     * A task that throws is abandoned; the exception does not reach the pool.
+     */
+    class ThreadPool {
+    public:
+        /**
+         * Task type.
+         */
+        using Task = std::function<void()>;
+
+        /**
+         * Creates the pool.
+         * @param threadCount number of worker threads; 0 means one per hardware thread.
+         */
+        explicit ThreadPool(size_t threadCount = 0);
+
+        /**
+         * Waits for all submitted tasks, then stops the workers.
+         */
+        ~ThreadPool();
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator = (const ThreadPool&) = delete;
+
+        /**
+         * Submits a task.
+         * Tasks are distributed round-robin and each worker runs its tasks in submission order,
+         * so tasks submitted first start first; imbalance is corrected by stealing.
+         * @param task task to execute.
+         */
+        void submit(Task task);
+
+        /**
+         * Blocks until every submitted task has finished.
+         */
+        void wait();
+
+        /**
+         * Returns the number of worker threads.
+         */
+        size_t size() const {
+            return m_threads.size();
+        }
+
+        /**
+         * Returns the index of the calling worker thread, or SIZE_MAX if not called from a worker.
+         * Useful for per-worker state.
+         */
+        static size_t current_index();
+
+    private:
+        struct Worker {
+            std::mutex mutex;
+            std::deque<Task> tasks;
+        };
+
+        std::vector<std::unique_ptr<Worker>> m_workers;
+        std::vector<std::thread> m_threads;
+        std::mutex m_mutex;
+        std::condition_variable m_wakeup;
+        std::condition_variable m_done;
+        std::atomic<size_t> m_queued{ 0 };
+        std::atomic<size_t> m_unfinished{ 0 };
+        std::atomic<size_t> m_next{ 0 };
+        bool m_stop{ false };
+
+        bool pop(size_t index, Task& task);
+        bool steal(size_t index, Task& task);
+        void run(size_t index);
+    };
+
+
+} //namespace cap
+
+
+#endif //CAP_THREADPOOL_HPP
@@ -0,0 +1,107 @@
+#ifndef CAP_DRIVER_HPP
+#define CAP_DRIVER_HPP
+
+
+#include <string>
+#include <vector>
+#include "CrossReferenceIndex.hpp"
+#include "Diagnostic.hpp"
+#include "MemoryStatistics.hpp"
+#include "ModuleLoader.hpp"
+
+
+namespace cap {
+
+
+    /**
+     * Build options.
+     */
+    struct BuildOptions {
+        //number of worker threads; 0 means one per hardware thread.
+        size_t jobs = 0;
+
+        //maximum number of diagnostics kept per file.
+        size_t diagnosticLimit = Diagnostics::DEFAULT_LIMIT;
+
+        //if set, memory is accounted per phase.
+        bool memoryStatistics = false;
+
+        //if set, each large file is lexed on an idle worker while it is parsed; see tokenize_and_parse.
+        bool pipeline = false;
+
+        //if set, the definitions and references of type names are indexed.
+        bool crossReferences = false;
+
+        //loader of imported modules, e.g. one kept across builds; if null, the build uses its own,
+        //with the diagnostic limit above. Modules are accounted in the memory statistics of the build
+        //that parses them. Builds that use the same loader must not run concurrently.
+        ModuleLoader* modules = nullptr;
+    };
+
+
+    /**
+     * Aggregate build statistics.
+     */
+    struct BuildStatistics {
+        size_t files = 0;
+        size_t bytes = 0;
+        size_t tokens = 0;
+        size_t declarations = 0;
+        size_t jobs = 0;
+
+        //distinct modules imported by the files.
+        size_t modules = 0;
+
+        //wall-clock time, in seconds.
+        double seconds = 0;
+    };
+
+
+    /**
+     * Build result.
+     */
+    struct BuildResult {
+        //the input files, followed by the imported modules; Diagnostic::file and Location::file index into this.
+        std::vector<std::string> files;
+
+        //diagnostics, sorted by file and position.
+        Diagnostics diagnostics{ Diagnostics::UNLIMITED };
+
+        //statistics.
+        BuildStatistics statistics;
+
+        //memory accounting, summed over the workers; filled if requested in the options.
+        MemoryStatistics memory;
+
+        //type name definitions and references, by file index; filled if requested in the options.
+        CrossReferenceIndex crossReferences;
+    };
+
+
+    /**
+     * Reads, tokenizes and parses the given files in parallel, and loads the modules they import.
+     * Larger files are scheduled first; workers steal from each other to balance the rest.
+     * Each imported module is parsed once, however many files import it; the input files
+     * are parsed first, so an input that is also imported is not parsed again.
+     * The declarations of a module are not visible to its importers.
+     * @param files files.
+     * @param options options.
+     * @return the merged diagnostics and the statistics.
+     */
+    BuildResult build(const std::vector<std::string>& files, const BuildOptions& options = BuildOptions());
+
+
+    /**
+     * Loads a manifest: one file per line; empty lines and lines starting with '#' are ignored.
+     * Relative paths are resolved against the directory of the manifest.
+     * @param path manifest path.
+     * @param files output; the manifest's files are appended to it.
+     * @return true if the manifest could be read.
+     */
+    bool load_manifest(const std::string& path, std::vector<std::string>& files);
+
+
+} //namespace cap
+
+
+#endif //CAP_DRIVER_HPP
@@ -0,0 +1,52 @@
+#ifndef CAP_EXPRESSION_HPP
+#define CAP_EXPRESSION_HPP
+
+
+#include <map>
+#include <string>
+#include "NodeAllocator.hpp"
+#include "parser.hpp"
+
+
+namespace cap {
+
+
+    /**
+     * Named integer constants visible to expressions, e.g. enum members.
+     */
+    using ConstantTable = std::map<std::string, int64_t, std::less<>>;
+
+
+    /**
+     * Maximum nesting depth of an expression: of its parentheses and prefix operators,
+     * and of the tree its operators build, e.g. by a long chain of additions;
+     * deeper expressions are reported instead of exhausting the stack when they are
+     * parsed, printed or destroyed.
+     */
+    static constexpr size_t MAX_EXPRESSION_DEPTH = 256;
+
+
+    /**
+     * Token iterator.
+     */
+    using TokenIterator = std::vector<Token>::const_iterator;
+
+
+    /**
+     * Parses the tokens of an expression by precedence climbing (Pratt parsing),
+     * folding integer constant subexpressions as they are built.
+     * Each token is examined once, so parse time is linear in the expression size.
+     * @param begin first token.
+     * @param end end of the expression's tokens; all of them must be consumed.
+     * @param constants known constants; names found here are folded.
+     * @param diagnostics diagnostics.
+     * @param allocator allocator of the nodes.
+     * @return the expression, or null on error.
+     */
+    std::shared_ptr<ASTExpression> parse_expression(TokenIterator begin, TokenIterator end, const ConstantTable& constants, Diagnostics& diagnostics, const NodeAllocator<ASTNode>& allocator);
+
+
+} //namespace cap
+
+
+#endif //CAP_EXPRESSION_HPP
@@ -0,0 +1,30 @@
+#ifndef CAP_FILE_HPP
+#define CAP_FILE_HPP
+
+
+#include <string>
+
+
+namespace cap {
+
+
+    /**
+     * Reads a whole file; files without a size, such as pipes, are read until their end.
+     * @param path path of the file.
+     * @param output output; its capacity is reused.
+     * @return true if the file could be read; false for directories.
+     */
+    bool read_file(const std::string& path, std::string& output);
+
+
+    /**
+     * Returns the canonical form of a path.
+     * @param path path; it need not exist.
+     */
+    std::string canonical_path(const std::string& path);
+
+
+} //namespace cap
+
+
+#endif //CAP_FILE_HPP
@@ -4,6 +4,8 @@
 
 #include <vector>
 #include "Error.hpp"
+#include "Diagnostic.hpp"
+#include "MemoryStatistics.hpp"
 
 
 namespace cap {
@@ -20,6 +22,7 @@ namespace cap {
         ENUM,
         VOID,
         INT,
+        IMPORT,
         STRING,
         CHARACTER,
         IDENTIFIER,
@@ -83,6 +86,34 @@ namespace cap {
     void tokenize(const std::string& input, std::vector<Token>& output, std::vector<Error>& errors);
 
 
+    /**
+     * Tokenization function.
+     * The input is validated as UTF-8; identifiers may contain XID_Start/XID_Continue characters.
+     * Errors are recorded as diagnostics; no exception is thrown.
+     * @param input input.
+     * @param output output.
+     * @param diagnostics diagnostics.
+     * @param statistics optional memory accounting.
+     */
+    void tokenize(const std::string& input, std::vector<Token>& output, Diagnostics& diagnostics, MemoryStatistics* statistics = nullptr);
+
+
+    /**
+     * Tokenizes a range of an input that is already validated as UTF-8, e.g. one chunk of a large file.
+     * The range must start at the beginning of a line and must not split a token, a comment or a string.
+     * Tokens refer into the input and are positioned as if the whole input had been tokenized.
+     * @param input the whole input.
+     * @param begin offset of the range.
+     * @param end end offset of the range.
+     * @param line line of the first character of the range.
+     * @param buffer scratch buffer that receives the text of the range.
+     * @param output output; the tokens of the range are appended to it.
+     * @param diagnostics diagnostics.
+     * @return false if the range has a syntax error.
+     */
+    bool tokenize_range(const std::string& input, size_t begin, size_t end, int line, std::string& buffer, std::vector<Token>& output, Diagnostics& diagnostics);
+
+
 } //namespace cap
 
 
@@ -2,7 +2,9 @@
 #define CAP_PARSER_HPP
 
 
+#include <cstdint>
 #include <memory>
+#include <memory_resource>
 #include <ostream>
 #include "lexer.hpp"
 
@@ -15,6 +17,9 @@ namespace parserlib {
 namespace cap {
 
 
+    class FileSymbols;
+
+
     /**
      * AST type enumeration.
      */
@@ -26,11 +31,13 @@ namespace cap {
         TYPE_IDENTIFIER,
         TYPE_PTR,
         NAME,
+        EXPRESSION,
         ENUM_MEMBER,
         ENUM,
         STRUCT_MEMBER,
         STRUCT,
-        TYPEDEF
+        TYPEDEF,
+        IMPORT
     };
 
 
@@ -147,6 +154,125 @@ namespace cap {
     };
 
 
+    /**
+     * Operators of expressions.
+     */
+    enum class OPERATOR {
+        ADD,
+        SUBTRACT,
+        MULTIPLY,
+        DIVIDE,
+        MODULO,
+        SHIFT_LEFT,
+        SHIFT_RIGHT,
+        BITWISE_AND,
+        BITWISE_OR,
+        BITWISE_XOR,
+        NEGATE,
+        PLUS,
+        COMPLEMENT,
+        LOGICAL_NOT
+    };
+
+
+    /**
+     * Returns the source text of an operator.
+     */
+    const char* operator_symbol(OPERATOR op);
+
+
+    /**
+     * Base class for expressions.
+     */
+    struct ASTExpression : ASTNode {
+        //true if the expression is an integer constant; its value is then folded.
+        bool constant = false;
+
+        //height of the expression tree; a literal or a name has height 1.
+        uint32_t height = 1;
+
+        //folded value.
+        int64_t value = 0;
+    };
+
+
+    /**
+     * Integer literal.
+     */
+    struct ASTIntegerLiteral : ASTExpression {
+        void print(size_t depth, std::basic_ostream<char>& stream) const override {
+            stream << value;
+        }
+    };
+
+
+    /**
+     * Floating point, string or character literal; it is never constant.
+     */
+    struct ASTLiteral : ASTExpression {
+        //source text, including the quotes of strings and characters.
+        std::string text;
+
+        void print(size_t depth, std::basic_ostream<char>& stream) const override {
+            stream << text;
+        }
+    };
+
+
+    /**
+     * Placeholder of an expression whose errors have been reported; it is never constant.
+     */
+    struct ASTErrorExpression : ASTExpression {
+        void print(size_t depth, std::basic_ostream<char>& stream) const override {
+            stream << "<error>";
+        }
+    };
+
+
+    /**
+     * Reference to a named constant.
+     */
+    struct ASTNameExpression : ASTExpression {
+        std::string name;
+
+        void print(size_t depth, std::basic_ostream<char>& stream) const override {
+            stream << name;
+        }
+    };
+
+
+    /**
+     * Unary expression.
+     */
+    struct ASTUnaryExpression : ASTExpression {
+        OPERATOR op;
+        std::shared_ptr<ASTExpression> operand;
+
+        void print(size_t depth, std::basic_ostream<char>& stream) const override {
+            stream << operator_symbol(op);
+            operand->print(depth, stream);
+        }
+    };
+
+
+    /**
+     * Binary expression.
+     */
+    struct ASTBinaryExpression : ASTExpression {
+        OPERATOR op;
+        std::shared_ptr<ASTExpression> left;
+        std::shared_ptr<ASTExpression> right;
+
+        void print(size_t depth, std::basic_ostream<char>& stream) const override {
+            stream << '(';
+            left->print(depth, stream);
+            stream << ' ' << operator_symbol(op) << ' ';
+            right->print(depth, stream);
+            stream << ')';
+        }
+    };
+
+
     /**
      * AST enum member.
      */
@@ -154,8 +280,19 @@ namespace cap {
         //name 
         std::string name;
 
+        //explicit value; null if the value is implicit.
+        std::shared_ptr<ASTExpression> expression;
+
+        //folded value.
+        int64_t value = 0;
+
         void print(size_t depth, std::basic_ostream<char>& stream) const override {
-            stream << "enum_member<"  << name << '>';
+            stream << "enum_member<"  << name;
+            if (expression) {
+                stream << " = ";
+                expression->print(depth, stream);
+            }
+            stream << '>';
         }
     };
 
@@ -191,10 +328,18 @@ namespace cap {
         //name 
         std::string name;
 
+        //initializer; may be null.
+        std::shared_ptr<ASTExpression> initializer;
+
         void print(size_t depth, std::basic_ostream<char>& stream) const override {
             stream << "struct_member<";
             typename_->print(depth, stream);
-            stream << ' ' << name << ">; \n";
+            stream << ' ' << name;
+            if (initializer) {
+                stream << " = ";
+                initializer->print(depth, stream);
+            }
+            stream << ">; \n";
         }
     };
 
@@ -238,12 +383,110 @@ namespace cap {
     };
 
 
+    /**
+     * Import of another file.
+     */
+    struct ASTImport : public ASTNode {
+        //path of the imported file, as written; relative paths are relative to the importing file.
+        std::string path;
+
+        void print(size_t depth, std::basic_ostream<char>& stream) const override {
+            stream << "import \"" << path << "\";\n";
+        }
+    };
+
+
+    /**
+     * Counters of the predictive dispatch of grammar alternations on the current thread.
+     * Every dispatch selects its alternative from the current token; backtracks
+     * counts the selected alternatives that failed nonetheless.
+     * Counting is compiled in only when CAP_GRAMMAR_STATISTICS is defined; otherwise the counters stay zero.
+     */
+    struct GrammarStatistics {
+        //number of dispatches.
+        size_t dispatches = 0;
+
+        //dispatches where no alternative starts with the current token.
+        size_t misses = 0;
+
+        //dispatches where the selected alternative failed after its first token.
+        size_t backtracks = 0;
+
+        //failed attempts an ordered choice of the alternatives, in the order given to predict,
+        //would have made before reaching the selected alternative.
+        size_t avoided = 0;
+    };
+
+
+    /**
+     * Returns the dispatch counters of the current thread.
+     */
+    GrammarStatistics& grammar_statistics();
+
+
+    /**
+     * Returns true if the dispatch counters are compiled in, i.e. if the parser was built with CAP_GRAMMAR_STATISTICS;
+     * the macro may differ in the translation units that read the counters.
+     */
+    bool grammar_statistics_enabled();
+
+
     /**
      * Parse a series of tokens into an AST tree.
      */
     void parse(const std::vector<Token>& input, std::vector<ASTNodePtr>& output, std::vector<Error>& errors);
 
 
+    /**
+     * Parse a series of tokens into an AST tree.
+     * Errors are recorded as diagnostics; no exception is thrown.
+     * AST memory is accounted in the optional statistics; the nodes remain accounted as current
+     * until the caller destroys them and calls MemoryStatistics::release_ast(), as Session::reset does.
+     * Type name definitions and references are collected in the optional symbols.
+     */
+    void parse(const std::vector<Token>& input, std::vector<ASTNodePtr>& output, Diagnostics& diagnostics, MemoryStatistics* statistics = nullptr, FileSymbols* symbols = nullptr);
+
+
+    /**
+     * Parser that receives the tokens of one declaration at a time, e.g. while the rest of the input is still being lexed.
+     * Enum constants of earlier declarations remain visible to later ones. Feeding the declarations of an input
+     * in order produces the same AST and diagnostics as parsing the whole input at once.
+     */
+    class DeclarationParser {
+    public:
+        /**
+         * Constructor.
+         * @param output output; the AST of each declaration is appended to it.
+         * @param diagnostics diagnostics.
+         * @param resource memory resource of the AST nodes.
+         * @param statistics optional memory accounting.
+         * @param symbols optional collection of type name definitions and references.
+         */
+        DeclarationParser(std::vector<ASTNodePtr>& output, Diagnostics& diagnostics, std::pmr::memory_resource* resource = std::pmr::new_delete_resource(), MemoryStatistics* statistics = nullptr, FileSymbols* symbols = nullptr);
+
+        DeclarationParser(const DeclarationParser&) = delete;
+        DeclarationParser& operator = (const DeclarationParser&) = delete;
+
+        /**
+         * Destructor.
+         */
+        ~DeclarationParser();
+
+        /**
+         * Parses the tokens of one declaration: they must start with the declaration's
+         * keyword and end before the keyword of the next declaration.
+         * @param tokens tokens.
+         * @return false if the tokens are not exactly one declaration; whole-input parsing
+         *  stops there too, so every later call is ignored and returns false.
+         */
+        bool parse(const std::vector<Token>& tokens);
+
+    private:
+        struct State;
+        std::unique_ptr<State> m_state;
+    };
+
+
 } //namespace cap
 
 
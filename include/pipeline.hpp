@@ -0,0 +1,66 @@
+#ifndef CAP_PIPELINE_HPP
+#define CAP_PIPELINE_HPP
+
+
+#include <chrono>
+#include <cstddef>
+#include <memory_resource>
+#include <string>
+#include <vector>
+#include "Session.hpp"
+
+
+namespace cap {
+
+
+    class ThreadPool;
+
+
+    /**
+     * Size of the chunks the pipelined lexer splits its input into.
+     * Inputs up to this size are tokenized and parsed sequentially.
+     */
+    static constexpr size_t PIPELINE_CHUNK_SIZE = 64 * 1024;
+
+
+    /**
+     * Time an idle pool worker has to take up the lexer task of a pipeline.
+     */
+    static constexpr std::chrono::microseconds PIPELINE_START_TIMEOUT{ 200 };
+
+
+    /**
+     * Tokenizes and parses the input concurrently.
+     * A lexer task lexes the input in chunks that end at line ends outside of comments, strings
+     * and character literals, and publishes the tokens of each chunk through a single-producer/single-consumer
+     * ring buffer. The calling thread parses each declaration as soon as the keyword of the next one,
+     * or the end of the input, has arrived; it waits only when that lookahead has not been lexed yet.
+     * The tokens, AST and diagnostics, including their order, are the same as those of tokenize followed by parse.
+     * @param input input; it must outlive the tokens.
+     * @param tokens output tokens.
+     * @param ast output AST.
+     * @param diagnostics diagnostics.
+     * @param resource memory resource of the AST nodes.
+     * @param statistics optional memory accounting; the lexer's transient match lists are not
+     *  accounted for inputs that are pipelined.
+     * @param symbols optional collection of type name definitions and references.
+     * @param pool optional pool to run the lexer task on, instead of a thread of its own. If no worker
+     *  takes the task up within PIPELINE_START_TIMEOUT, the pool is busy, and the calling thread
+     *  tokenizes and parses sequentially; so pipelining never uses more threads than the pool has.
+     */
+    void tokenize_and_parse(const std::string& input, std::vector<Token>& tokens, std::vector<ASTNodePtr>& ast, Diagnostics& diagnostics, std::pmr::memory_resource* resource = std::pmr::new_delete_resource(), MemoryStatistics* statistics = nullptr, FileSymbols* symbols = nullptr, ThreadPool* pool = nullptr);
+
+
+    /**
+     * Tokenizes and parses the session's source concurrently, into the session's tokens and AST.
+     * @param session session.
+     * @param diagnostics diagnostics.
+     * @param pool optional pool to run the lexer task on.
+     */
+    void tokenize_and_parse(Session& session, Diagnostics& diagnostics, ThreadPool* pool = nullptr);
+
+
+} //namespace cap
+
+
+#endif //CAP_PIPELINE_HPP
@@ -0,0 +1,200 @@
+#ifndef CAP_PREDICTIVE_HPP
+#define CAP_PREDICTIVE_HPP
+
+
+#include <array>
+#include <cstdint>
+#include <initializer_list>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include "parser.hpp"
+#include "parserlib.hpp"
+
+
+namespace cap {
+
+
+    /**************************************************************************
+       Predictive dispatch for token grammars.
+
+       Grammar expressions that start with lead<TOKEN::X>() carry their FIRST
+       set in their type; predict(a, b, ...) checks at compile time that the
+       FIRST sets of its alternatives are disjoint and replaces ordered choice
+       with a jump table indexed by the current token, so no alternative is
+       ever tried only to fail on its first token.
+
+       The dispatch counters of GrammarStatistics are compiled in only when
+       CAP_GRAMMAR_STATISTICS is defined where the grammar is instantiated,
+       i.e. in parser.cpp; grammar_statistics_enabled() tells which.
+       The alternatives of predict are listed in the order of the ordered
+       choice they replace, which the avoided counter is measured against.
+     **************************************************************************/
+
+
+    //number of token types.
+    static constexpr size_t TOKEN_COUNT = static_cast<size_t>(TOKEN::SLASH) + 1;
+
+
+    static_assert(TOKEN_COUNT <= 64, "token sets are 64-bit masks");
+
+
+    /**
+     * Compile-time set of tokens.
+     */
+    template <TOKEN... Tokens> struct token_set {
+        static constexpr uint64_t bits = (uint64_t(0) | ... | (uint64_t(1) << static_cast<size_t>(Tokens)));
+    };
+
+
+    /**
+     * A grammar expression annotated with its FIRST set.
+     */
+    template <class First, class Parser> class predicted : public Parser {
+    public:
+        using first = First;
+
+        explicit predicted(const Parser& parser) : Parser(parser) {
+        }
+    };
+
+
+    //true if no token is in more than one of the sets
+    constexpr bool disjoint(std::initializer_list<uint64_t> sets) {
+        uint64_t seen = 0;
+        for (const uint64_t set : sets) {
+            if (seen & set) {
+                return false;
+            }
+            seen |= set;
+        }
+        return true;
+    }
+
+
+    template <class T> struct is_predicted : std::false_type {};
+    template <class First, class Parser> struct is_predicted<predicted<First, Parser>> : std::true_type {};
+
+
+    /**
+     * Creates the terminal that starts a predicted expression.
+     */
+    template <TOKEN Token> auto lead() {
+        return predicted<token_set<Token>, decltype(parserlib::terminal(Token))>(parserlib::terminal(Token));
+    }
+
+
+    //a sequence starts with its first element, so it keeps its FIRST set
+    template <class First, class Parser, class Right> auto operator >> (const predicted<First, Parser>& left, const Right& right) {
+        auto result = static_cast<const Parser&>(left) >> right;
+        return predicted<First, decltype(result)>(result);
+    }
+
+
+    //tagging a match does not change the FIRST set
+    template <class First, class Parser> auto operator == (const predicted<First, Parser>& parser, AST tag) {
+        auto result = static_cast<const Parser&>(parser) == tag;
+        return predicted<First, decltype(result)>(result);
+    }
+
+
+    /**
+     * Ordered choice between alternatives with disjoint FIRST sets, dispatched on the current token.
+     */
+    template <class... Alternatives> class dispatch_parser : public parserlib::parser<dispatch_parser<Alternatives...>> {
+    public:
+        static_assert((is_predicted<Alternatives>::value && ...), "every alternative must start with lead<TOKEN>()");
+
+        static_assert(disjoint({ Alternatives::first::bits... }), "the FIRST sets of the alternatives must be disjoint");
+
+        explicit dispatch_parser(const Alternatives&... alternatives) : m_alternatives(alternatives...) {
+        }
+
+        template <class ParseContext> bool parse(ParseContext& pc) const {
+            return dispatch(pc, [&pc](const auto& alternative) { return alternative.parse(pc); });
+        }
+
+        template <class ParseContext> bool parse_left_recursion_start(ParseContext& pc) const {
+            return dispatch(pc, [&pc](const auto& alternative) { return alternative.parse_left_recursion_start(pc); });
+        }
+
+        template <class ParseContext, class State> bool parse_left_recursion_continuation(ParseContext& pc, const State& state) const {
+            return dispatch(pc, [&pc, &state](const auto& alternative) { return alternative.parse_left_recursion_continuation(pc, state); });
+        }
+
+    private:
+        static constexpr int8_t NONE = -1;
+
+        std::tuple<Alternatives...> m_alternatives;
+
+        //the alternative selected by each token
+        static constexpr std::array<int8_t, TOKEN_COUNT> make_table() {
+            std::array<int8_t, TOKEN_COUNT> result{};
+            const uint64_t firsts[] = { Alternatives::first::bits... };
+            for (size_t token = 0; token < TOKEN_COUNT; ++token) {
+                result[token] = NONE;
+                for (size_t index = 0; index < sizeof...(Alternatives); ++index) {
+                    if (firsts[index] & (uint64_t(1) << token)) {
+                        result[token] = static_cast<int8_t>(index);
+                    }
+                }
+            }
+            return result;
+        }
+
+        static constexpr std::array<int8_t, TOKEN_COUNT> table = make_table();
+
+        template <size_t Index, class F> static bool invoke(const std::tuple<Alternatives...>& alternatives, F& f) {
+            return f(std::get<Index>(alternatives));
+        }
+
+        template <class F, size_t... Indexes> bool jump(size_t index, F& f, std::index_sequence<Indexes...>) const {
+            using function = bool (*)(const std::tuple<Alternatives...>&, F&);
+            static constexpr function functions[] = { &invoke<Indexes, F>... };
+            return functions[index](m_alternatives, f);
+        }
+
+        static void count(size_t GrammarStatistics::* counter, size_t amount = 1) {
+#ifdef CAP_GRAMMAR_STATISTICS
+            grammar_statistics().*counter += amount;
+#endif
+        }
+
+        template <class ParseContext, class F> bool dispatch(ParseContext& pc, F&& f) const {
+            count(&GrammarStatistics::dispatches);
+
+            if (!pc.valid()) {
+                count(&GrammarStatistics::misses);
+                return false;
+            }
+
+            const int8_t index = table[static_cast<size_t>(pc.position->token)];
+            if (index == NONE) {
+                count(&GrammarStatistics::misses);
+                return false;
+            }
+
+            count(&GrammarStatistics::avoided, static_cast<size_t>(index));
+
+            if (!jump(static_cast<size_t>(index), f, std::index_sequence_for<Alternatives...>())) {
+                count(&GrammarStatistics::backtracks);
+                return false;
+            }
+
+            return true;
+        }
+    };
+
+
+    /**
+     * Creates a predictive choice between the given alternatives.
+     */
+    template <class... Alternatives> dispatch_parser<Alternatives...> predict(const Alternatives&... alternatives) {
+        return dispatch_parser<Alternatives...>(alternatives...);
+    }
+
+
+} //namespace cap
+
+
+#endif //CAP_PREDICTIVE_HPP
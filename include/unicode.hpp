@@ -0,0 +1,60 @@
+#ifndef CAP_UNICODE_HPP
+#define CAP_UNICODE_HPP
+
+
+#include <cstddef>
+#include <string>
+#include "Diagnostic.hpp"
+
+
+namespace cap {
+
+
+    /**
+     * Decodes one UTF-8 sequence.
+     * @param data input.
+     * @param size number of bytes available; must be greater than 0.
+     * @param codePoint output; set only if the sequence is valid.
+     * @param valid output; set to true if the sequence is well-formed.
+     * @return number of bytes consumed; for a malformed sequence, the length of its maximal valid prefix, at least 1.
+     */
+    size_t decode_utf8(const char* data, size_t size, char32_t& codePoint, bool& valid);
+
+
+    /**
+     * Finds the first malformed UTF-8 sequence.
+     * Uses a vectorised validator that checks 64 bytes per step when the CPU supports it.
+     * @param data input; must start at a sequence boundary.
+     * @param size input size.
+     * @param ascii output; set to false if a non-ASCII byte was seen before the returned offset.
+     * @return offset of the first malformed sequence, or size if the input is valid.
+     */
+    size_t find_invalid_utf8(const char* data, size_t size, bool& ascii);
+
+
+    /**
+     * Validates UTF-8 input, reporting every malformed sequence at its position.
+     * @param input input.
+     * @param diagnostics diagnostics.
+     * @param ascii optional output; set to true if the input is pure ASCII.
+     * @return true if the input is valid.
+     */
+    bool validate_utf8(const std::string& input, Diagnostics& diagnostics, bool* ascii = nullptr);
+
+
+    /**
+     * Checks if a code point has the XID_Start property.
+     */
+    bool is_xid_start(char32_t codePoint);
+
+
+    /**
+     * Checks if a code point has the XID_Continue property.
+     */
+    bool is_xid_continue(char32_t codePoint);
+
+
+} //namespace cap
+
+
+#endif //CAP_UNICODE_HPP
@@ -0,0 +1,125 @@
+#include "CrossReferenceIndex.hpp"
+#include <algorithm>
+#include <numeric>
+
+
+namespace cap {
+
+
+    //the range of a sorted location vector that belongs to the given file
+    static std::pair<std::vector<Location>::iterator, std::vector<Location>::iterator> file_range(std::vector<Location>& locations, uint32_t file) {
+        const auto begin = std::lower_bound(locations.begin(), locations.end(), file, [](const Location& location, uint32_t f) { return location.file < f; });
+        const auto end = std::upper_bound(begin, locations.end(), file, [](uint32_t f, const Location& location) { return f < location.file; });
+        return { begin, end };
+    }
+
+
+    //insert the locations of a file, which must be sorted, into a sorted location vector without that file
+    static void insert_file(std::vector<Location>& locations, const std::vector<Location>& fileLocations) {
+        if (fileLocations.empty()) {
+            return;
+        }
+        const auto position = file_range(locations, fileLocations.front().file).first;
+        locations.insert(position, fileLocations.begin(), fileLocations.end());
+    }
+
+
+    //update
+    void CrossReferenceIndex::update(uint32_t file, const FileSymbols& symbols) {
+        remove(file);
+
+        const std::vector<FileSymbols::Record>& records = symbols.m_records;
+        if (records.empty()) {
+            return;
+        }
+
+        if (file >= m_files.size()) {
+            m_files.resize(file + 1);
+        }
+
+        const auto name = [&symbols](const FileSymbols::Record& record) {
+            return std::string_view(symbols.m_text.data() + record.offset, record.length);
+        };
+
+        //group the records by name, in position order within each name
+        std::vector<uint32_t> order(records.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+            const int cmp = name(records[a]).compare(name(records[b]));
+            return cmp < 0 || (cmp == 0 && records[a].position < records[b].position);
+        });
+
+        std::vector<Location> definitions;
+        std::vector<Location> references;
+
+        for (auto group = order.begin(); group != order.end(); ) {
+            const std::string_view groupName = name(records[*group]);
+
+            definitions.clear();
+            references.clear();
+
+            auto it = group;
+            for (; it != order.end() && name(records[*it]) == groupName; ++it) {
+                const FileSymbols::Record& record = records[*it];
+                (record.definition ? definitions : references).push_back(Location{ file, record.position });
+            }
+
+            SymbolMap::iterator symbol = m_symbols.find(groupName);
+            if (symbol == m_symbols.end()) {
+                symbol = m_symbols.emplace(std::string(groupName), Symbol()).first;
+            }
+
+            insert_file(symbol->second.definitions, definitions);
+            insert_file(symbol->second.references, references);
+            m_files[file].push_back(symbol);
+
+            group = it;
+        }
+    }
+
+
+    //remove
+    void CrossReferenceIndex::remove(uint32_t file) {
+        if (file >= m_files.size()) {
+            return;
+        }
+
+        for (const SymbolMap::iterator& symbol : m_files[file]) {
+            for (std::vector<Location>* locations : { &symbol->second.definitions, &symbol->second.references }) {
+                const auto range = file_range(*locations, file);
+                locations->erase(range.first, range.second);
+            }
+
+            //a symbol without locations is not listed by any file
+            if (symbol->second.definitions.empty() && symbol->second.references.empty()) {
+                m_symbols.erase(symbol);
+            }
+        }
+
+        m_files[file].clear();
+    }
+
+
+    //find
+    const CrossReferenceIndex::Symbol* CrossReferenceIndex::find(std::string_view name) const {
+        const auto it = m_symbols.find(name);
+        return it != m_symbols.end() ? &it->second : nullptr;
+    }
+
+
+    //definition
+    const Location* CrossReferenceIndex::definition(std::string_view name) const {
+        const Symbol* symbol = find(name);
+        return symbol && !symbol->definitions.empty() ? &symbol->definitions.front() : nullptr;
+    }
+
+
+    //references
+    const std::vector<Location>& CrossReferenceIndex::references(std::string_view name) const {
+        static const std::vector<Location> none;
+        const Symbol* symbol = find(name);
+        return symbol ? symbol->references : none;
+    }
+
+
+} //namespace cap
@@ -0,0 +1,239 @@
+#include "Diagnostic.hpp"
+#include <functional>
+#include <iterator>
+
+
+namespace cap {
+
+
+    //message templates, indexed by DIAGNOSTIC
+    static const char* const messages[] = {
+        "syntax error",
+        "Expected {0}",
+        "Invalid declaration",
+        "cannot read file",
+        "{0}",
+        "invalid UTF-8 sequence",
+        "invalid character {0} in identifier",
+        "integer literal {0} is too large",
+        "division by zero",
+        "invalid shift count",
+        "value of {0} is not an integer constant",
+        "cannot import {0}",
+        "import cycle: {0}",
+        "expression is nested more than {0} levels deep",
+        "redefinition of constant {0}"
+    };
+
+
+    static_assert(std::size(messages) == static_cast<size_t>(DIAGNOSTIC::COUNT), "one message template per DIAGNOSTIC id");
+
+
+    //constructor
+    Diagnostics::Diagnostics(size_t limit, uint32_t file)
+        : m_limit(limit)
+        , m_file(file)
+        , m_index(0, Key{ this }, Key{ this })
+    {
+    }
+
+
+    //copy constructor; the index refers to this, so it is rebuilt
+    Diagnostics::Diagnostics(const Diagnostics& other)
+        : m_limit(other.m_limit)
+        , m_file(other.m_file)
+        , m_dropped(other.m_dropped)
+        , m_duplicates(other.m_duplicates)
+        , m_records(other.m_records)
+        , m_text(other.m_text)
+        , m_index(0, Key{ this }, Key{ this })
+    {
+        reindex();
+    }
+
+
+    //move constructor
+    Diagnostics::Diagnostics(Diagnostics&& other)
+        : m_limit(other.m_limit)
+        , m_file(other.m_file)
+        , m_dropped(other.m_dropped)
+        , m_duplicates(other.m_duplicates)
+        , m_records(std::move(other.m_records))
+        , m_text(std::move(other.m_text))
+        , m_index(0, Key{ this }, Key{ this })
+    {
+        reindex();
+        other.clear();
+    }
+
+
+    //copy assignment
+    Diagnostics& Diagnostics::operator = (const Diagnostics& other) {
+        if (this != &other) {
+            m_limit = other.m_limit;
+            m_file = other.m_file;
+            m_dropped = other.m_dropped;
+            m_duplicates = other.m_duplicates;
+            m_records = other.m_records;
+            m_text = other.m_text;
+            reindex();
+        }
+        return *this;
+    }
+
+
+    //move assignment
+    Diagnostics& Diagnostics::operator = (Diagnostics&& other) {
+        if (this != &other) {
+            m_limit = other.m_limit;
+            m_file = other.m_file;
+            m_dropped = other.m_dropped;
+            m_duplicates = other.m_duplicates;
+            m_records = std::move(other.m_records);
+            m_text = std::move(other.m_text);
+            reindex();
+            other.clear();
+        }
+        return *this;
+    }
+
+
+    //report
+    bool Diagnostics::report(DIAGNOSTIC id, const Position& position, std::string_view argument0, std::string_view argument1) {
+        if (full()) {
+            ++m_dropped;
+            return false;
+        }
+
+        const size_t textSize = m_text.size();
+
+        m_records.push_back(Diagnostic{ id, m_file, position, { store(argument0), store(argument1) } });
+
+        //the candidate is inserted by index; on collision with an identical record, it is undone
+        if (!m_index.insert(static_cast<uint32_t>(m_records.size() - 1)).second) {
+            m_records.pop_back();
+            m_text.resize(textSize);
+            ++m_duplicates;
+            return false;
+        }
+
+        return true;
+    }
+
+
+    //append
+    void Diagnostics::append(const Diagnostics& other) {
+        for (const Diagnostic& diagnostic : other.m_records) {
+            const size_t textSize = m_text.size();
+
+            m_records.push_back(Diagnostic{ diagnostic.id, diagnostic.file, diagnostic.position, { store(other.argument(diagnostic, 0)), store(other.argument(diagnostic, 1)) } });
+
+            //same deduplication as report
+            if (!m_index.insert(static_cast<uint32_t>(m_records.size() - 1)).second) {
+                m_records.pop_back();
+                m_text.resize(textSize);
+                ++m_duplicates;
+            }
+        }
+
+        m_dropped += other.m_dropped;
+        m_duplicates += other.m_duplicates;
+    }
+
+
+    //transfer
+    void Diagnostics::transfer(const Diagnostics& other) {
+        for (const Diagnostic& diagnostic : other.m_records) {
+            report(diagnostic.id, diagnostic.position, other.argument(diagnostic, 0), other.argument(diagnostic, 1));
+        }
+
+        m_dropped += other.m_dropped;
+        m_duplicates += other.m_duplicates;
+    }
+
+
+    //format
+    std::string Diagnostics::format(const Diagnostic& diagnostic) const {
+        std::string result;
+
+        for (const char* s = messages[static_cast<size_t>(diagnostic.id)]; *s; ++s) {
+            if (s[0] == '{' && s[1] >= '0' && s[1] < '0' + static_cast<char>(Diagnostic::MAX_ARGUMENTS) && s[2] == '}') {
+                result += argument(diagnostic, s[1] - '0');
+                s += 2;
+            }
+            else {
+                result += *s;
+            }
+        }
+
+        return result;
+    }
+
+
+    //render
+    void Diagnostics::render(std::vector<Error>& errors) const {
+        for (const Diagnostic& diagnostic : m_records) {
+            errors.push_back(Error{ diagnostic.position, format(diagnostic) });
+        }
+    }
+
+
+    //clear
+    void Diagnostics::clear() {
+        m_dropped = 0;
+        m_duplicates = 0;
+        m_records.clear();
+        m_text.clear();
+        m_index.clear();
+    }
+
+
+    //copy an argument into the text buffer
+    Diagnostic::Argument Diagnostics::store(std::string_view text) {
+        const Diagnostic::Argument result{ static_cast<uint32_t>(m_text.size()), static_cast<uint32_t>(text.size()) };
+        m_text += text;
+        return result;
+    }
+
+
+    //rebuild the deduplication index
+    void Diagnostics::reindex() {
+        m_index = std::unordered_set<uint32_t, Key, Key>(m_records.size(), Key{ this }, Key{ this });
+        for (uint32_t index = 0; index < m_records.size(); ++index) {
+            m_index.insert(index);
+        }
+    }
+
+
+    //hash a record
+    size_t Diagnostics::Key::operator ()(uint32_t index) const {
+        const Diagnostic& diagnostic = diagnostics->m_records[index];
+        size_t result = static_cast<size_t>(diagnostic.id);
+        const auto combine = [&](size_t value) { result ^= value + 0x9e3779b9 + (result << 6) + (result >> 2); };
+        combine(diagnostic.file);
+        combine(static_cast<size_t>(diagnostic.position.line));
+        combine(static_cast<size_t>(diagnostic.position.column));
+        for (size_t i = 0; i < Diagnostic::MAX_ARGUMENTS; ++i) {
+            combine(std::hash<std::string_view>()(diagnostics->argument(diagnostic, i)));
+        }
+        return result;
+    }
+
+
+    //compare two records
+    bool Diagnostics::Key::operator ()(uint32_t a, uint32_t b) const {
+        const Diagnostic& da = diagnostics->m_records[a];
+        const Diagnostic& db = diagnostics->m_records[b];
+        if (da.id != db.id || da.file != db.file || da.position != db.position) {
+            return false;
+        }
+        for (size_t i = 0; i < Diagnostic::MAX_ARGUMENTS; ++i) {
+            if (diagnostics->argument(da, i) != diagnostics->argument(db, i)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+
+} //namespace cap
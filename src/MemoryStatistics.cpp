@@ -0,0 +1,124 @@
+#include "MemoryStatistics.hpp"
+#include <iomanip>
+#include "parser.hpp"
+
+
+namespace cap {
+
+
+    //phase names, indexed by PHASE
+    static const char* const phaseNames[] = {
+        "source",
+        "tokens",
+        "matches",
+        "ast",
+        "diagnostics"
+    };
+
+
+    //AST kind names, indexed by AST
+    static const char* const astNames[] = {
+        "TYPE_VOID",
+        "TYPE_CHAR",
+        "TYPE_INT",
+        "TYPE_DOUBLE",
+        "TYPE_IDENTIFIER",
+        "TYPE_PTR",
+        "NAME",
+        "EXPRESSION",
+        "ENUM_MEMBER",
+        "ENUM",
+        "STRUCT_MEMBER",
+        "STRUCT",
+        "TYPEDEF",
+        "IMPORT"
+    };
+
+
+    static_assert(sizeof(astNames) / sizeof(astNames[0]) == static_cast<size_t>(AST::IMPORT) + 1, "astNames must list every AST kind");
+
+
+    //ast counter
+    MemoryCounter& MemoryStatistics::ast(AST kind) {
+        const size_t index = static_cast<size_t>(kind);
+        if (index >= m_ast.size()) {
+            m_ast.resize(index + 1);
+        }
+        return m_ast[index];
+    }
+
+
+    //release ast
+    void MemoryStatistics::release_ast() {
+        (*this)[PHASE::AST].deallocate((*this)[PHASE::AST].current);
+        for (MemoryCounter& counter : m_ast) {
+            counter.deallocate(counter.current);
+        }
+    }
+
+
+    //merge
+    void MemoryStatistics::merge(const MemoryStatistics& other) {
+        tokens += other.tokens;
+        astNodes += other.astNodes;
+        for (size_t index = 0; index < PHASE_COUNT; ++index) {
+            m_phases[index].merge(other.m_phases[index]);
+        }
+        if (other.m_ast.size() > m_ast.size()) {
+            m_ast.resize(other.m_ast.size());
+        }
+        for (size_t index = 0; index < other.m_ast.size(); ++index) {
+            m_ast[index].merge(other.m_ast[index]);
+        }
+    }
+
+
+    //bytes per token
+    double MemoryStatistics::bytes_per_token() const {
+        size_t bytes = 0;
+        for (const MemoryCounter& counter : m_phases) {
+            bytes += counter.bytes;
+        }
+        return tokens ? static_cast<double>(bytes) / tokens : 0;
+    }
+
+
+    //bytes per ast node
+    double MemoryStatistics::bytes_per_ast_node() const {
+        return astNodes ? static_cast<double>((*this)[PHASE::AST].bytes) / astNodes : 0;
+    }
+
+
+    static void print_counter(std::basic_ostream<char>& stream, const char* name, const MemoryCounter& counter) {
+        stream << "  " << std::left << std::setw(18) << name << std::right
+               << std::setw(14) << counter.bytes
+               << std::setw(14) << counter.allocations
+               << std::setw(14) << counter.peak << '\n';
+    }
+
+
+    //print
+    void MemoryStatistics::print(std::basic_ostream<char>& stream) const {
+        stream << "  " << std::left << std::setw(18) << "phase" << std::right
+               << std::setw(14) << "bytes"
+               << std::setw(14) << "allocations"
+               << std::setw(14) << "peak bytes" << '\n';
+
+        for (size_t index = 0; index < PHASE_COUNT; ++index) {
+            print_counter(stream, phaseNames[index], m_phases[index]);
+
+            if (index == static_cast<size_t>(PHASE::AST)) {
+                for (size_t kind = 0; kind < m_ast.size(); ++kind) {
+                    if (m_ast[kind].allocations > 0) {
+                        print_counter(stream, (std::string("  ") + astNames[kind]).c_str(), m_ast[kind]);
+                    }
+                }
+            }
+        }
+
+        stream << "  " << tokens << " tokens, " << bytes_per_token() << " bytes/token; "
+               << astNodes << " AST nodes, " << bytes_per_ast_node() << " bytes/AST node\n";
+    }
+
+
+} //namespace cap
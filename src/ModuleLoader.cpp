@@ -0,0 +1,285 @@
+#include "ModuleLoader.hpp"
+#include <algorithm>
+#include <filesystem>
+#include "MemoryStatistics.hpp"
+
+
+namespace cap {
+
+
+    //FNV-1a hash
+    static uint64_t hash_source(const std::string& source) {
+        uint64_t result = 14695981039346656037ULL;
+        for (const char c : source) {
+            result ^= static_cast<unsigned char>(c);
+            result *= 1099511628211ULL;
+        }
+        return result;
+    }
+
+
+    //constructor
+    ModuleLoader::ModuleLoader(size_t diagnosticLimit)
+        : m_diagnosticLimit(diagnosticLimit)
+    {
+    }
+
+
+    //module
+    std::shared_ptr<const Module> ModuleLoader::module(const std::string& path, MemoryStatistics* statistics) {
+        const std::string canonical = canonical_path(path);
+
+        //the first request for a path loads it; later ones wait for the same future
+        std::promise<std::shared_ptr<const Module>> promise;
+        ModuleFuture future;
+        bool owner = false;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            const auto it = m_modules.find(canonical);
+            if (it != m_modules.end()) {
+                future = it->second;
+            }
+            else {
+                future = promise.get_future().share();
+                m_modules.emplace(canonical, future);
+                owner = true;
+            }
+        }
+
+        //load does not throw, so a failure is not cached as an exception
+        if (owner) {
+            promise.set_value(load(canonical, statistics));
+        }
+
+        return future.get();
+    }
+
+
+    /**
+     * Depth-first walk over an import graph.
+     */
+    struct ImportWalk {
+        ModuleLoader& loader;
+        Diagnostics& diagnostics;
+        MemoryStatistics* statistics;
+        std::vector<std::shared_ptr<const Module>>& result;
+
+        //modules on the current import chain
+        std::vector<std::string> chain;
+
+        //visited modules; true while on the chain
+        std::unordered_map<std::string, bool> visited;
+
+        ImportWalk(ModuleLoader& loader, Diagnostics& diagnostics, MemoryStatistics* statistics, std::vector<std::shared_ptr<const Module>>& result)
+            : loader(loader)
+            , diagnostics(diagnostics)
+            , statistics(statistics)
+            , result(result)
+        {
+        }
+
+        //visit a module imported by the import declaration at the given position of the root file
+        void visit(const std::string& path, const Position& position) {
+            const auto [it, inserted] = visited.emplace(path, true);
+            if (!inserted) {
+                if (it->second) {
+                    report_cycle(path, position);
+                }
+                return;
+            }
+
+            chain.push_back(path);
+
+            const std::shared_ptr<const Module> module = loader.module(path, statistics);
+            if (module) {
+                for (const std::string& import : module->imports) {
+                    visit(import, position);
+                }
+            }
+            else {
+                diagnostics.report(DIAGNOSTIC::CANNOT_IMPORT, position, path);
+            }
+
+            chain.pop_back();
+            visited[path] = false;
+
+            //after its imports
+            if (module) {
+                result.push_back(module);
+            }
+        }
+
+        //report the part of the chain that starts at the given path
+        void report_cycle(const std::string& path, const Position& position) {
+            std::string text;
+            for (auto it = std::find(chain.begin(), chain.end(), path); it != chain.end(); ++it) {
+                text += *it;
+                text += " -> ";
+            }
+            text += path;
+            diagnostics.report(DIAGNOSTIC::IMPORT_CYCLE, position, text);
+        }
+    };
+
+
+    //seed
+    void ModuleLoader::seed(const std::string& path, const std::vector<ModuleImport>& imports) {
+        std::shared_ptr<Module> module = std::make_shared<Module>();
+        module->path = canonical_path(path);
+        for (const ModuleImport& import : imports) {
+            module->imports.push_back(import.path);
+        }
+
+        std::promise<std::shared_ptr<const Module>> promise;
+        promise.set_value(module);
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_modules[module->path] = promise.get_future().share();
+    }
+
+
+    //forget
+    void ModuleLoader::forget(const std::string& path) {
+        const std::string canonical = canonical_path(path);
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_modules.erase(canonical);
+    }
+
+
+    //load imports
+    std::vector<std::shared_ptr<const Module>> ModuleLoader::load_imports(const std::string& path, const std::vector<ModuleImport>& imports, Diagnostics& diagnostics, MemoryStatistics* statistics) {
+        std::vector<std::shared_ptr<const Module>> result;
+
+        ImportWalk walk(*this, diagnostics, statistics, result);
+
+        //the importing file is the start of every chain
+        const std::string root = canonical_path(path);
+        walk.chain.push_back(root);
+        walk.visited.emplace(root, true);
+
+        for (const ModuleImport& import : imports) {
+            walk.visit(import.path, import.position);
+        }
+
+        return result;
+    }
+
+
+    //load imports of declarations
+    std::vector<std::shared_ptr<const Module>> ModuleLoader::load_imports(const std::string& path, const std::vector<ASTNodePtr>& declarations, Diagnostics& diagnostics, MemoryStatistics* statistics) {
+        return load_imports(path, resolve_imports(path, declarations), diagnostics, statistics);
+    }
+
+
+    //size
+    size_t ModuleLoader::size() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_modules.size();
+    }
+
+
+    //read and parse a module; its imports are only resolved, not loaded. Any failure,
+    //e.g. an import of a directory, makes the module unreadable, for the importer to report
+    std::shared_ptr<const Module> ModuleLoader::load(const std::string& path, MemoryStatistics* statistics) {
+        try {
+            std::shared_ptr<ModuleContent> content = std::make_shared<ModuleContent>();
+            content->diagnostics = Diagnostics(m_diagnosticLimit);
+            if (!read_file(path, content->source)) {
+                return nullptr;
+            }
+            content->hash = hash_source(content->source);
+
+            std::shared_ptr<Module> result = std::make_shared<Module>();
+            result->path = path;
+            result->content = share(std::move(content), statistics);
+
+            for (ModuleImport& import : resolve_imports(path, result->content->ast)) {
+                result->imports.push_back(std::move(import.path));
+            }
+
+            return result;
+        }
+        catch (...) {
+            return nullptr;
+        }
+    }
+
+
+    //return the cached content equal to the given one, or parse and cache the given one
+    std::shared_ptr<const ModuleContent> ModuleLoader::share(std::shared_ptr<ModuleContent> content, MemoryStatistics* statistics) {
+        //the first module with this content publishes it before parsing it; copies wait for the parse
+        std::promise<std::shared_ptr<const ModuleContent>> promise;
+        ContentFuture future;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            const auto range = m_contents.equal_range(content->hash);
+            for (auto it = range.first; it != range.second; ++it) {
+                if (it->second.content->source == content->source) {
+                    future = it->second.parsed;
+                    break;
+                }
+            }
+            if (!future.valid()) {
+                future = promise.get_future().share();
+                m_contents.emplace(content->hash, ContentEntry{ content, future });
+            }
+            else {
+                content.reset();
+            }
+        }
+
+        //the source of a published content is not modified, so it can be compared while it is parsed
+        if (content) {
+            try {
+                std::vector<Token> tokens;
+                tokenize(content->source, tokens, content->diagnostics, statistics);
+                parse(tokens, content->ast, content->diagnostics, statistics, &content->symbols);
+
+                //the source, the AST and the diagnostics stay with the loader; the tokens do not
+                if (statistics) {
+                    (*statistics)[PHASE::SOURCE].allocate(content->source.capacity());
+                    (*statistics)[PHASE::TOKENS].deallocate(tokens.capacity() * sizeof(Token));
+                    if (content->diagnostics.memory_usage() > 0) {
+                        (*statistics)[PHASE::DIAGNOSTICS].allocate(content->diagnostics.memory_usage());
+                    }
+                }
+
+                promise.set_value(content);
+            }
+            catch (...) {
+                //the failure is not cached; a later copy parses again
+                {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    const auto range = m_contents.equal_range(content->hash);
+                    for (auto it = range.first; it != range.second; ++it) {
+                        if (it->second.content == content) {
+                            m_contents.erase(it);
+                            break;
+                        }
+                    }
+                }
+                promise.set_exception(std::current_exception());
+            }
+        }
+
+        return future.get();
+    }
+
+
+    //resolve imports
+    std::vector<ModuleImport> resolve_imports(const std::string& path, const std::vector<ASTNodePtr>& declarations) {
+        std::vector<ModuleImport> result;
+
+        const std::filesystem::path directory = std::filesystem::path(path).parent_path();
+
+        for (const ASTNodePtr& declaration : declarations) {
+            if (const auto import = dynamic_cast<const ASTImport*>(declaration.get())) {
+                result.push_back(ModuleImport{ canonical_path((directory / import->path).string()), import->position });
+            }
+        }
+
+        return result;
+    }
+
+
+} //namespace cap
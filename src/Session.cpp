@@ -0,0 +1,70 @@
+#include "Session.hpp"
+
+
+namespace cap {
+
+
+    //constructor
+    Session::Session(size_t arenaSize)
+        : m_buffer(arenaSize)
+    {
+        m_arena.emplace(m_buffer.data(), m_buffer.size(), &m_upstream);
+    }
+
+
+    //destructor; the members are declared before the arena, so they would outlive it
+    Session::~Session() {
+        ast.clear();
+        tokens.clear();
+    }
+
+
+    //reset
+    void Session::reset() {
+        //the nodes must be destroyed before their memory is released
+        ast.clear();
+        tokens.clear();
+        source.clear();
+
+        //if the last file did not fit, grow the buffer so that the next one will
+        const size_t spilled = m_upstream.allocated;
+        m_arena.reset();
+        m_upstream.allocated = 0;
+        if (spilled > 0) {
+            m_buffer.resize(m_buffer.size() + spilled);
+        }
+
+        m_arena.emplace(m_buffer.data(), m_buffer.size(), &m_upstream);
+
+        if (statistics) {
+            statistics->release_ast();
+        }
+    }
+
+
+    //allocate from the global heap
+    void* Session::Upstream::do_allocate(size_t bytes, size_t alignment) {
+        allocated += bytes;
+        return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+    }
+
+
+    //deallocate to the global heap
+    void Session::Upstream::do_deallocate(void* p, size_t bytes, size_t alignment) {
+        std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+    }
+
+
+    //equality
+    bool Session::Upstream::do_is_equal(const std::pmr::memory_resource& other) const noexcept {
+        return this == &other;
+    }
+
+
+    //tokenize into a session
+    void tokenize(const std::string& input, Session& session, Diagnostics& diagnostics) {
+        tokenize(input, session.tokens, diagnostics, session.statistics);
+    }
+
+
+} //namespace cap
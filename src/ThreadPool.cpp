@@ -0,0 +1,141 @@
+#include "ThreadPool.hpp"
+#include <algorithm>
+#include <cstdint>
+
+
+namespace cap {
+
+
+    //index of the worker running on this thread
+    static thread_local size_t currentIndex = SIZE_MAX;
+
+
+    //create the workers
+    ThreadPool::ThreadPool(size_t threadCount) {
+        if (threadCount == 0) {
+            threadCount = std::max(1u, std::thread::hardware_concurrency());
+        }
+
+        for (size_t i = 0; i < threadCount; ++i) {
+            m_workers.push_back(std::make_unique<Worker>());
+        }
+
+        //threads are started after all workers exist, since any of them may be stolen from
+        for (size_t i = 0; i < threadCount; ++i) {
+            m_threads.emplace_back([this, i]() { run(i); });
+        }
+    }
+
+
+    //finish pending work, then join
+    ThreadPool::~ThreadPool() {
+        wait();
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop = true;
+        }
+        m_wakeup.notify_all();
+
+        for (std::thread& thread : m_threads) {
+            thread.join();
+        }
+    }
+
+
+    //put the task in the next worker's deque
+    void ThreadPool::submit(Task task) {
+        Worker& worker = *m_workers[m_next++ % m_workers.size()];
+
+        m_unfinished.fetch_add(1);
+
+        {
+            std::lock_guard<std::mutex> lock(worker.mutex);
+            worker.tasks.push_back(std::move(task));
+        }
+
+        //the counter is raised under the pool mutex so that a sleeping worker cannot miss it
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_queued.fetch_add(1);
+        }
+        m_wakeup.notify_one();
+    }
+
+
+    //wait for the unfinished counter to reach zero
+    void ThreadPool::wait() {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_done.wait(lock, [this]() { return m_unfinished.load() == 0; });
+    }
+
+
+    //pop the oldest task of the given worker
+    bool ThreadPool::pop(size_t index, Task& task) {
+        Worker& worker = *m_workers[index];
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        if (worker.tasks.empty()) {
+            return false;
+        }
+        task = std::move(worker.tasks.front());
+        worker.tasks.pop_front();
+        m_queued.fetch_sub(1);
+        return true;
+    }
+
+
+    //take the oldest task of another worker
+    bool ThreadPool::steal(size_t index, Task& task) {
+        for (size_t offset = 1; offset < m_workers.size(); ++offset) {
+            Worker& victim = *m_workers[(index + offset) % m_workers.size()];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (!victim.tasks.empty()) {
+                task = std::move(victim.tasks.front());
+                victim.tasks.pop_front();
+                m_queued.fetch_sub(1);
+                return true;
+            }
+        }
+        return false;
+    }
+
+
+    //current index
+    size_t ThreadPool::current_index() {
+        return currentIndex;
+    }
+
+
+    //worker loop
+    void ThreadPool::run(size_t index) {
+        currentIndex = index;
+
+        for (;;) {
+            Task task;
+
+            if (pop(index, task) || steal(index, task)) {
+                //a throwing task must not end the worker; it would never be joined
+                try {
+                    task();
+                }
+                catch (...) {
+                }
+
+                if (m_unfinished.fetch_sub(1) == 1) {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    m_done.notify_all();
+                }
+
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wakeup.wait(lock, [this]() { return m_stop || m_queued.load() > 0; });
+            if (m_stop && m_queued.load() == 0) {
+                return;
+            }
+        }
+    }
+
+
+} //namespace cap
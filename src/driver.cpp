@@ -0,0 +1,262 @@
+#include "driver.hpp"
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <unordered_set>
+#include "Session.hpp"
+#include "ThreadPool.hpp"
+#include "pipeline.hpp"
+
+
+namespace cap {
+
+
+    /**
+     * Per-file state; each file is written by exactly one task.
+     */
+    struct FileResult {
+        size_t bytes = 0;
+        size_t tokens = 0;
+        size_t declarations = 0;
+        Diagnostics diagnostics;
+        FileSymbols symbols;
+        bool parsed = false;
+        std::vector<ModuleImport> importDeclarations;
+        std::vector<std::shared_ptr<const Module>> imports;
+    };
+
+
+    //run a task of a file, reporting its exceptions in the file's diagnostics
+    template <class F> static void run_guarded(FileResult& result, F&& task) {
+        try {
+            task();
+        }
+        catch (const std::exception& ex) {
+            result.diagnostics.report(DIAGNOSTIC::INTERNAL_ERROR, Position{ 0, 0 }, ex.what());
+        }
+        catch (...) {
+            result.diagnostics.report(DIAGNOSTIC::INTERNAL_ERROR, Position{ 0, 0 }, "unknown exception");
+        }
+    }
+
+
+    //read, tokenize and parse one file
+    static void build_file(const std::string& path, FileResult& result, const BuildOptions& options, ThreadPool& pool, MemoryStatistics* statistics) {
+        //one session per worker thread, reused for every file the worker processes
+        static thread_local Session session;
+        session.statistics = statistics;
+        session.symbols = options.crossReferences ? &result.symbols : nullptr;
+        session.reset();
+
+        const size_t sourceCapacity = session.source.capacity();
+        const bool readOk = read_file(path, session.source);
+        if (statistics) {
+            (*statistics)[PHASE::SOURCE].reallocate(sourceCapacity, session.source.capacity());
+        }
+        if (!readOk) {
+            result.diagnostics.report(DIAGNOSTIC::CANNOT_READ_FILE, Position{ 0, 0 });
+            return;
+        }
+
+        if (options.pipeline) {
+            //the lexer stage runs on an idle worker, if there is one
+            tokenize_and_parse(session, result.diagnostics, &pool);
+        }
+        else {
+            tokenize(session.source, session, result.diagnostics);
+            parse(session, result.diagnostics);
+        }
+
+        //the imports are loaded once every input is parsed, so that inputs are not parsed again as modules
+        result.importDeclarations = resolve_imports(path, session.ast);
+        result.parsed = true;
+
+        if (statistics && result.diagnostics.memory_usage() > 0) {
+            (*statistics)[PHASE::DIAGNOSTICS].allocate(result.diagnostics.memory_usage());
+        }
+
+        result.bytes = session.source.size();
+        result.tokens = session.tokens.size();
+        result.declarations = session.ast.size();
+    }
+
+
+    //add the imported modules that are not input files under new file ids, with their diagnostics and symbols
+    static void append_modules(const std::vector<FileResult>& results, const BuildOptions& options, BuildResult& result) {
+        std::unordered_set<std::string> seen;
+        for (const std::string& file : result.files) {
+            seen.insert(canonical_path(file));
+        }
+
+        size_t modules = 0;
+
+        for (const FileResult& fileResult : results) {
+            for (const std::shared_ptr<const Module>& module : fileResult.imports) {
+                if (!seen.insert(module->path).second) {
+                    continue;
+                }
+
+                ++modules;
+
+                //inputs seeded by another build have no content here
+                if (!module->content) {
+                    continue;
+                }
+
+                const uint32_t file = static_cast<uint32_t>(result.files.size());
+                result.files.push_back(module->path);
+
+                const Diagnostics& moduleDiagnostics = module->content->diagnostics;
+                if (!moduleDiagnostics.empty() || moduleDiagnostics.dropped() > 0) {
+                    Diagnostics diagnostics(options.diagnosticLimit, file);
+                    diagnostics.transfer(moduleDiagnostics);
+                    result.diagnostics.append(diagnostics);
+                }
+
+                if (options.crossReferences) {
+                    result.crossReferences.update(file, module->content->symbols);
+                }
+            }
+        }
+
+        result.statistics.modules += modules;
+    }
+
+
+    //build
+    BuildResult build(const std::vector<std::string>& files, const BuildOptions& options) {
+        const auto startTime = std::chrono::steady_clock::now();
+
+        std::vector<FileResult> results(files.size());
+        for (size_t index = 0; index < files.size(); ++index) {
+            results[index].diagnostics = Diagnostics(options.diagnosticLimit, static_cast<uint32_t>(index));
+        }
+
+        //schedule the largest files first, so that the small ones fill the gaps at the end
+        std::vector<std::pair<std::uintmax_t, size_t>> order;
+        order.reserve(files.size());
+        for (size_t index = 0; index < files.size(); ++index) {
+            std::error_code ec;
+            const std::uintmax_t size = std::filesystem::file_size(files[index], ec);
+            order.emplace_back(ec ? 0 : size, index);
+        }
+        std::stable_sort(order.begin(), order.end(), [](const auto& a, const auto& b) { return a.first > b.first; });
+
+        BuildResult result;
+
+        ModuleLoader buildModules(options.diagnosticLimit);
+        ModuleLoader& modules = options.modules ? *options.modules : buildModules;
+
+        {
+            ThreadPool pool(options.jobs);
+            result.statistics.jobs = pool.size();
+
+            //memory is accounted per worker, then summed
+            std::vector<MemoryStatistics> workerMemory(options.memoryStatistics ? pool.size() : 0);
+
+            for (const auto& [size, index] : order) {
+                pool.submit([&files, &results, &workerMemory, &options, &pool, index = index]() {
+                    MemoryStatistics* statistics = workerMemory.empty() ? nullptr : &workerMemory[ThreadPool::current_index()];
+                    run_guarded(results[index], [&]() {
+                        build_file(files[index], results[index], options, pool, statistics);
+                    });
+                });
+            }
+
+            pool.wait();
+
+            //the inputs are registered as parsed before any import is loaded
+            for (size_t index = 0; index < files.size(); ++index) {
+                if (results[index].parsed) {
+                    modules.seed(files[index], results[index].importDeclarations);
+                }
+            }
+
+            for (size_t index = 0; index < files.size(); ++index) {
+                if (results[index].importDeclarations.empty()) {
+                    continue;
+                }
+                pool.submit([&files, &results, &workerMemory, &modules, index]() {
+                    MemoryStatistics* statistics = workerMemory.empty() ? nullptr : &workerMemory[ThreadPool::current_index()];
+                    FileResult& fileResult = results[index];
+                    run_guarded(fileResult, [&]() {
+                        fileResult.imports = modules.load_imports(files[index], fileResult.importDeclarations, fileResult.diagnostics, statistics);
+                    });
+                });
+            }
+
+            pool.wait();
+
+            //the inputs may change before the loader is used again
+            for (size_t index = 0; index < files.size(); ++index) {
+                if (results[index].parsed) {
+                    modules.forget(files[index]);
+                }
+            }
+
+            for (const MemoryStatistics& memory : workerMemory) {
+                result.memory.merge(memory);
+            }
+        }
+
+        //merge the per-file results in input order
+        for (size_t index = 0; index < results.size(); ++index) {
+            const FileResult& fileResult = results[index];
+            result.statistics.bytes += fileResult.bytes;
+            result.statistics.tokens += fileResult.tokens;
+            result.statistics.declarations += fileResult.declarations;
+            result.diagnostics.append(fileResult.diagnostics);
+            if (options.crossReferences) {
+                result.crossReferences.update(static_cast<uint32_t>(index), fileResult.symbols);
+            }
+        }
+        result.statistics.files = files.size();
+        result.files = files;
+
+        append_modules(results, options, result);
+
+        //the order must not depend on scheduling
+        result.diagnostics.sort([&result](const Diagnostic& a, const Diagnostic& b) {
+            if (a.file != b.file) {
+                const int cmp = result.files[a.file].compare(result.files[b.file]);
+                if (cmp != 0) {
+                    return cmp < 0;
+                }
+            }
+            return a.position < b.position;
+        });
+
+        result.statistics.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+        return result;
+    }
+
+
+    //load manifest
+    bool load_manifest(const std::string& path, std::vector<std::string>& files) {
+        std::ifstream stream(path);
+        if (!stream) {
+            return false;
+        }
+
+        const std::filesystem::path base = std::filesystem::path(path).parent_path();
+
+        std::string line;
+        while (std::getline(stream, line)) {
+            //trim
+            const size_t first = line.find_first_not_of(" \t\r");
+            if (first == std::string::npos || line[first] == '#') {
+                continue;
+            }
+            const size_t last = line.find_last_not_of(" \t\r");
+            const std::filesystem::path file = line.substr(first, last - first + 1);
+
+            files.push_back(file.is_absolute() ? file.string() : (base / file).string());
+        }
+
+        return true;
+    }
+
+
+} //namespace cap
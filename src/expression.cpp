@@ -0,0 +1,414 @@
+#include "expression.hpp"
+#include <algorithm>
+#include <limits>
+#include <string>
+
+
+namespace cap {
+
+
+    //operator symbols, indexed by OPERATOR
+    static const char* const operatorSymbols[] = {
+        "+",
+        "-",
+        "*",
+        "/",
+        "%",
+        "<<",
+        ">>",
+        "&",
+        "|",
+        "^",
+        "-",
+        "+",
+        "~",
+        "!"
+    };
+
+
+    //operator symbol
+    const char* operator_symbol(OPERATOR op) {
+        return operatorSymbols[static_cast<size_t>(op)];
+    }
+
+
+    //binding power of prefix operators; higher than any binary operator
+    static constexpr int UNARY_POWER = 100;
+
+
+    /**
+     * Precedence-climbing expression parser.
+     */
+    class ExpressionParser {
+    public:
+        ExpressionParser(TokenIterator begin, TokenIterator end, const ConstantTable& constants, Diagnostics& diagnostics, const NodeAllocator<ASTNode>& allocator)
+            : m_it(begin)
+            , m_end(end)
+            , m_constants(constants)
+            , m_diagnostics(diagnostics)
+            , m_allocator(allocator)
+        {
+        }
+
+        //parse the whole range
+        std::shared_ptr<ASTExpression> parse() {
+            std::shared_ptr<ASTExpression> result = parse(0);
+            if (result && m_it != m_end) {
+                m_diagnostics.report(DIAGNOSTIC::EXPECTED, m_it->position, "operator");
+                return nullptr;
+            }
+            return result;
+        }
+
+    private:
+        TokenIterator m_it;
+        TokenIterator m_end;
+        const ConstantTable& m_constants;
+        Diagnostics& m_diagnostics;
+        NodeAllocator<ASTNode> m_allocator;
+        size_t m_depth = 0;
+
+        //an operator is one level above its deepest operand; operator chains are limited
+        //here, since they nest without recursion, e.g. 1 + 1 + ... + 1
+        bool set_height(ASTExpression& node, uint32_t operandHeight) {
+            if (operandHeight >= MAX_EXPRESSION_DEPTH) {
+                m_diagnostics.report(DIAGNOSTIC::EXPRESSION_TOO_DEEP, node.position, std::to_string(MAX_EXPRESSION_DEPTH));
+                return false;
+            }
+            node.height = operandHeight + 1;
+            return true;
+        }
+
+        template <class T> std::shared_ptr<T> make_node(const Position& position) {
+            std::shared_ptr<T> result = allocate_node<T>(m_allocator);
+            result->position = position;
+            return result;
+        }
+
+        //the second token of a two-character operator must immediately follow the first
+        bool is_adjacent(TOKEN token) const {
+            const TokenIterator next = m_it + 1;
+            return next != m_end && next->token == token && next->position.line == m_it->position.line && next->position.column == m_it->position.column + 1;
+        }
+
+        //recognize a binary operator at the current token; returns its binding power, or 0 if there is none
+        int binary_operator(OPERATOR& op, size_t& length) const {
+            if (m_it == m_end) {
+                return 0;
+            }
+
+            length = 1;
+
+            switch (m_it->token) {
+                case TOKEN::STAR:
+                    op = OPERATOR::MULTIPLY;
+                    return 10;
+
+                case TOKEN::SLASH:
+                    op = OPERATOR::DIVIDE;
+                    return 10;
+
+                case TOKEN::PERCENT:
+                    op = OPERATOR::MODULO;
+                    return 10;
+
+                case TOKEN::PLUS:
+                    op = OPERATOR::ADD;
+                    return 9;
+
+                case TOKEN::MINUS:
+                    op = OPERATOR::SUBTRACT;
+                    return 9;
+
+                case TOKEN::LESS_THAN:
+                    if (is_adjacent(TOKEN::LESS_THAN)) {
+                        op = OPERATOR::SHIFT_LEFT;
+                        length = 2;
+                        return 8;
+                    }
+                    return 0;
+
+                case TOKEN::GREATER_THAN:
+                    if (is_adjacent(TOKEN::GREATER_THAN)) {
+                        op = OPERATOR::SHIFT_RIGHT;
+                        length = 2;
+                        return 8;
+                    }
+                    return 0;
+
+                case TOKEN::AMBERSAND:
+                    op = OPERATOR::BITWISE_AND;
+                    return 7;
+
+                case TOKEN::CARET:
+                    op = OPERATOR::BITWISE_XOR;
+                    return 6;
+
+                case TOKEN::VERTICAL_BAR:
+                    op = OPERATOR::BITWISE_OR;
+                    return 5;
+
+                default:
+                    return 0;
+            }
+        }
+
+        //parse operators that bind tighter than minPower; every nested operand, parenthesized
+        //or not, comes through here, so this is where the recursion is limited
+        std::shared_ptr<ASTExpression> parse(int minPower) {
+            if (m_depth == MAX_EXPRESSION_DEPTH) {
+                m_diagnostics.report(DIAGNOSTIC::EXPRESSION_TOO_DEEP, (m_it == m_end ? m_it - 1 : m_it)->position, std::to_string(MAX_EXPRESSION_DEPTH));
+                return nullptr;
+            }
+
+            ++m_depth;
+            std::shared_ptr<ASTExpression> result = parse_operators(minPower);
+            --m_depth;
+            return result;
+        }
+
+        std::shared_ptr<ASTExpression> parse_operators(int minPower) {
+            std::shared_ptr<ASTExpression> left = parse_prefix();
+
+            while (left) {
+                OPERATOR op = OPERATOR::ADD;
+                size_t length;
+                const int power = binary_operator(op, length);
+                if (power <= minPower) {
+                    break;
+                }
+
+                const Position position = m_it->position;
+                m_it += length;
+
+                //left-associative: the right operand only takes tighter operators
+                std::shared_ptr<ASTExpression> right = parse(power);
+                if (!right) {
+                    return nullptr;
+                }
+
+                left = make_binary(op, position, std::move(left), std::move(right));
+            }
+
+            return left;
+        }
+
+        //parse a literal, a name, a parenthesized expression or a prefix operator
+        std::shared_ptr<ASTExpression> parse_prefix() {
+            if (m_it == m_end) {
+                m_diagnostics.report(DIAGNOSTIC::EXPECTED, (m_it - 1)->position, "expression");
+                return nullptr;
+            }
+
+            const Token& token = *m_it;
+
+            switch (token.token) {
+                case TOKEN::INTEGER:
+                    ++m_it;
+                    return make_integer(token);
+
+                case TOKEN::IDENTIFIER:
+                    ++m_it;
+                    return make_name(token);
+
+                case TOKEN::FLOAT:
+                case TOKEN::STRING:
+                case TOKEN::CHARACTER:
+                    ++m_it;
+                    return make_literal(token);
+
+                case TOKEN::OPENING_PARENTHESIS: {
+                    ++m_it;
+                    std::shared_ptr<ASTExpression> result = parse(0);
+                    if (!result) {
+                        return nullptr;
+                    }
+                    if (m_it == m_end || m_it->token != TOKEN::CLOSING_PARENTHESIS) {
+                        m_diagnostics.report(DIAGNOSTIC::EXPECTED, (m_it == m_end ? m_it - 1 : m_it)->position, "')'");
+                        return nullptr;
+                    }
+                    ++m_it;
+                    return result;
+                }
+
+                case TOKEN::MINUS:
+                    return parse_unary(OPERATOR::NEGATE);
+
+                case TOKEN::PLUS:
+                    return parse_unary(OPERATOR::PLUS);
+
+                case TOKEN::TILDE:
+                    return parse_unary(OPERATOR::COMPLEMENT);
+
+                case TOKEN::EXCLAMATION_MARK:
+                    return parse_unary(OPERATOR::LOGICAL_NOT);
+
+                default:
+                    m_diagnostics.report(DIAGNOSTIC::EXPECTED, token.position, "expression");
+                    return nullptr;
+            }
+        }
+
+        std::shared_ptr<ASTExpression> parse_unary(OPERATOR op) {
+            const Position position = m_it->position;
+            ++m_it;
+
+            std::shared_ptr<ASTExpression> operand = parse(UNARY_POWER);
+            if (!operand) {
+                return nullptr;
+            }
+
+            std::shared_ptr<ASTUnaryExpression> result = make_node<ASTUnaryExpression>(position);
+            result->op = op;
+            result->operand = std::move(operand);
+            if (!set_height(*result, result->operand->height)) {
+                return nullptr;
+            }
+
+            //fold
+            if (result->operand->constant) {
+                const uint64_t value = static_cast<uint64_t>(result->operand->value);
+                result->constant = true;
+                switch (op) {
+                    case OPERATOR::NEGATE:
+                        result->value = static_cast<int64_t>(0 - value);
+                        break;
+
+                    case OPERATOR::PLUS:
+                        result->value = static_cast<int64_t>(value);
+                        break;
+
+                    case OPERATOR::COMPLEMENT:
+                        result->value = static_cast<int64_t>(~value);
+                        break;
+
+                    default:
+                        result->value = value == 0;
+                        break;
+                }
+            }
+
+            return result;
+        }
+
+        std::shared_ptr<ASTExpression> make_integer(const Token& token) {
+            uint64_t value = 0;
+            for (const char c : token.content) {
+                const uint64_t digit = static_cast<uint64_t>(c - '0');
+                if (value > (static_cast<uint64_t>(std::numeric_limits<int64_t>::max()) - digit) / 10) {
+                    m_diagnostics.report(DIAGNOSTIC::INTEGER_TOO_LARGE, token.position, token.content);
+                    return nullptr;
+                }
+                value = value * 10 + digit;
+            }
+
+            std::shared_ptr<ASTIntegerLiteral> result = make_node<ASTIntegerLiteral>(token.position);
+            result->constant = true;
+            result->value = static_cast<int64_t>(value);
+            return result;
+        }
+
+        std::shared_ptr<ASTExpression> make_literal(const Token& token) {
+            std::shared_ptr<ASTLiteral> result = make_node<ASTLiteral>(token.position);
+            result->text = token.content;
+            return result;
+        }
+
+        std::shared_ptr<ASTExpression> make_name(const Token& token) {
+            std::shared_ptr<ASTNameExpression> result = make_node<ASTNameExpression>(token.position);
+            result->name = token.content;
+
+            //fold known constants
+            const auto it = m_constants.find(token.content);
+            if (it != m_constants.end()) {
+                result->constant = true;
+                result->value = it->second;
+            }
+
+            return result;
+        }
+
+        std::shared_ptr<ASTExpression> make_binary(OPERATOR op, const Position& position, std::shared_ptr<ASTExpression> left, std::shared_ptr<ASTExpression> right) {
+            std::shared_ptr<ASTBinaryExpression> result = make_node<ASTBinaryExpression>(position);
+            result->op = op;
+            result->left = std::move(left);
+            result->right = std::move(right);
+            if (!set_height(*result, std::max(result->left->height, result->right->height))) {
+                return nullptr;
+            }
+
+            if (!result->left->constant || !result->right->constant) {
+                return result;
+            }
+
+            //fold; arithmetic wraps around like unsigned 64-bit integers
+            const int64_t a = result->left->value;
+            const int64_t b = result->right->value;
+            const uint64_t ua = static_cast<uint64_t>(a);
+            const uint64_t ub = static_cast<uint64_t>(b);
+
+            switch (op) {
+                case OPERATOR::ADD:
+                    result->value = static_cast<int64_t>(ua + ub);
+                    break;
+
+                case OPERATOR::SUBTRACT:
+                    result->value = static_cast<int64_t>(ua - ub);
+                    break;
+
+                case OPERATOR::MULTIPLY:
+                    result->value = static_cast<int64_t>(ua * ub);
+                    break;
+
+                case OPERATOR::DIVIDE:
+                case OPERATOR::MODULO:
+                    if (b == 0) {
+                        m_diagnostics.report(DIAGNOSTIC::DIVISION_BY_ZERO, position);
+                        return nullptr;
+                    }
+                    if (a == std::numeric_limits<int64_t>::min() && b == -1) {
+                        result->value = op == OPERATOR::DIVIDE ? a : 0;
+                    }
+                    else {
+                        result->value = op == OPERATOR::DIVIDE ? a / b : a % b;
+                    }
+                    break;
+
+                case OPERATOR::SHIFT_LEFT:
+                case OPERATOR::SHIFT_RIGHT:
+                    if (b < 0 || b >= 64) {
+                        m_diagnostics.report(DIAGNOSTIC::INVALID_SHIFT, position);
+                        return nullptr;
+                    }
+                    result->value = op == OPERATOR::SHIFT_LEFT ? static_cast<int64_t>(ua << b) : a >> b;
+                    break;
+
+                case OPERATOR::BITWISE_AND:
+                    result->value = a & b;
+                    break;
+
+                case OPERATOR::BITWISE_OR:
+                    result->value = a | b;
+                    break;
+
+                case OPERATOR::BITWISE_XOR:
+                    result->value = a ^ b;
+                    break;
+
+                default:
+                    return result;
+            }
+
+            result->constant = true;
+            return result;
+        }
+    };
+
+
+    //parse expression
+    std::shared_ptr<ASTExpression> parse_expression(TokenIterator begin, TokenIterator end, const ConstantTable& constants, Diagnostics& diagnostics, const NodeAllocator<ASTNode>& allocator) {
+        return ExpressionParser(begin, end, constants, diagnostics, allocator).parse();
+    }
+
+
+} //namespace cap
@@ -0,0 +1,55 @@
+#include "file.hpp"
+#include <filesystem>
+#include <fstream>
+
+
+namespace cap {
+
+
+    //read a whole file into the given buffer, reusing its capacity
+    bool read_file(const std::string& path, std::string& output) {
+        //a directory can be opened, but not read
+        std::error_code ec;
+        if (std::filesystem::is_directory(path, ec)) {
+            return false;
+        }
+
+        std::ifstream stream(path, std::ios::binary);
+        if (!stream) {
+            return false;
+        }
+
+        output.clear();
+
+        //the size of a regular file is read at once; it is only a hint, since pipes have no size,
+        //files under /proc report none, and a file may grow while it is read
+        const std::uintmax_t size = std::filesystem::is_regular_file(path, ec) ? std::filesystem::file_size(path, ec) : 0;
+        if (!ec && size > 0) {
+            output.resize(static_cast<size_t>(size));
+            stream.read(output.data(), static_cast<std::streamsize>(size));
+            output.resize(static_cast<size_t>(stream.gcount()));
+        }
+
+        //the rest is streamed
+        char buffer[65536];
+        while (stream) {
+            stream.read(buffer, sizeof(buffer));
+            output.append(buffer, static_cast<size_t>(stream.gcount()));
+        }
+
+        return !stream.bad();
+    }
+
+
+    //canonical path
+    std::string canonical_path(const std::string& path) {
+        std::error_code ec;
+        const std::filesystem::path result = std::filesystem::weakly_canonical(path, ec);
+        if (ec) {
+            return std::filesystem::absolute(path, ec).lexically_normal().string();
+        }
+        return result.string();
+    }
+
+
+} //namespace cap
@@ -1,4 +1,6 @@
 #include "lexer.hpp"
+#include <cstdio>
+#include "unicode.hpp"
 #include "parserlib.hpp"
 
 
@@ -49,7 +51,20 @@ namespace cap {
     static auto digit = range('0', '9');
 
 
-    static auto identifier = ((letter | '_') >> *(letter | digit | '_')) == TOKEN::IDENTIFIER;
+    static auto continuation_byte = range(0x80, 0xBF);
+
+
+    //a non-ASCII character; whether it may appear in an identifier is checked after lexing
+    static auto utf8_character = range(0xC2, 0xDF) >> continuation_byte
+                               | range(0xE0, 0xEF) >> continuation_byte >> continuation_byte
+                               | range(0xF0, 0xF4) >> continuation_byte >> continuation_byte >> continuation_byte;
+
+
+    //not followed by an identifier character, so that identifiers like `important` stay identifiers
+    static auto keyword_import = (terminal("import") >> !(letter | digit | '_' | utf8_character)) == TOKEN::IMPORT;
+
+
+    static auto identifier = ((letter | '_' | utf8_character) >> *(letter | digit | '_' | utf8_character)) == TOKEN::IDENTIFIER;
 
 
     static auto float_number = (*digit >> terminal('.') >> -one_of("eE") >> -one_of("+-") >> +digit) == TOKEN::FLOAT;
@@ -99,6 +114,7 @@ namespace cap {
                       | keyword_enum
                       | keyword_void
                       | keyword_int
+                      | keyword_import
                       | string
                       | character
                       | identifier
@@ -141,27 +157,118 @@ namespace cap {
     static auto lexer = *(whitespace | token);
 
 
-    //tokenize
-    void tokenize(const std::string& input, std::vector<Token>& output, std::vector<Error>& errors) {
-        //reset the output variable
-        output.clear();
+    //check that the non-ASCII characters of identifiers are XID_Start/XID_Continue
+    static void check_identifiers(std::vector<Token>::const_iterator begin, std::vector<Token>::const_iterator end, Diagnostics& diagnostics) {
+        for (auto it = begin; it != end; ++it) {
+            const Token& token = *it;
+            if (token.token != TOKEN::IDENTIFIER) {
+                continue;
+            }
+
+            const std::string_view content = token.content;
+            for (size_t offset = 0; offset < content.size(); ) {
+                //ASCII characters are already restricted by the grammar
+                if (static_cast<unsigned char>(content[offset]) < 0x80) {
+                    ++offset;
+                    continue;
+                }
+
+                char32_t codePoint;
+                bool valid;
+                const size_t length = decode_utf8(content.data() + offset, content.size() - offset, codePoint, valid);
+
+                //malformed sequences are reported by the UTF-8 validation
+                if (valid && !(offset == 0 ? is_xid_start(codePoint) : is_xid_continue(codePoint))) {
+                    char name[16];
+                    std::snprintf(name, sizeof(name), "U+%04X", static_cast<unsigned>(codePoint));
+                    diagnostics.report(DIAGNOSTIC::INVALID_IDENTIFIER_CHARACTER, Position{ token.position.line, token.position.column + static_cast<int>(offset) }, name);
+                }
+
+                offset += length;
+            }
+        }
+    }
+
 
+    //lex the text into the output; the text starts at the beginning of the given line and
+    //its tokens are made to refer into the input at origin
+    static bool lex(const std::string& text, const char* origin, int line, std::vector<Token>& output, Diagnostics& diagnostics, MemoryStatistics* statistics) {
         //create the parse context
-        auto pc = parse_context(input);
+        auto pc = parse_context(text);
 
         //parse 
         const bool ok = parse(lexer, pc);
 
         //if error, set the remaining text as not recognized
         if (!ok) {
-            errors.push_back(Error{ Position{ pc.position.line(), pc.position.column() }, "syntax error" });
+            diagnostics.report(DIAGNOSTIC::SYNTAX_ERROR, Position{ pc.position.line() + line - 1, pc.position.column() });
         }
 
         //convert matches to tokens
+        output.reserve(output.size() + pc.matches.size());
         for (const auto& match : pc.matches) {
-            output.push_back(Token{ match.tag, Position{ match.begin.line(), match.begin.column() }, match.input() });
+            const std::string_view content = match.input();
+            output.push_back(Token{ match.tag, Position{ match.begin.line() + line - 1, match.begin.column() }, std::string_view(origin + (content.data() - text.data()), content.size()) });
+        }
+
+        //account the match list, which is freed on return
+        if (statistics && pc.matches.capacity() > 0) {
+            const size_t matchBytes = pc.matches.capacity() * sizeof(pc.matches[0]);
+            (*statistics)[PHASE::MATCHES].allocate(matchBytes);
+            (*statistics)[PHASE::MATCHES].deallocate(matchBytes);
+        }
+
+        return ok;
+    }
+
+
+    //tokenize
+    void tokenize(const std::string& input, std::vector<Token>& output, Diagnostics& diagnostics, MemoryStatistics* statistics) {
+        //reset the output variable
+        output.clear();
+        const size_t outputCapacity = output.capacity();
+
+        //validate the encoding; pure ASCII input needs no identifier checks
+        bool ascii;
+        validate_utf8(input, diagnostics, &ascii);
+
+        lex(input, input.data(), 1, output, diagnostics, statistics);
+
+        if (!ascii) {
+            check_identifiers(output.begin(), output.end(), diagnostics);
         }
 
+        //account the token vector
+        if (statistics) {
+            (*statistics)[PHASE::TOKENS].reallocate(outputCapacity * sizeof(Token), output.capacity() * sizeof(Token));
+            statistics->tokens += output.size();
+        }
+    }
+
+
+    //tokenize range
+    bool tokenize_range(const std::string& input, size_t begin, size_t end, int line, std::string& buffer, std::vector<Token>& output, Diagnostics& diagnostics) {
+        buffer.assign(input, begin, end - begin);
+
+        const size_t first = output.size();
+        const bool ok = lex(buffer, input.data() + begin, line, output, diagnostics, nullptr);
+
+        //find_invalid_utf8 only ever clears the flag
+        bool ascii = true;
+        find_invalid_utf8(buffer.data(), buffer.size(), ascii);
+        if (!ascii) {
+            check_identifiers(output.begin() + first, output.end(), diagnostics);
+        }
+
+        return ok;
+    }
+
+
+    //tokenize with errors
+    void tokenize(const std::string& input, std::vector<Token>& output, std::vector<Error>& errors) {
+        Diagnostics diagnostics(Diagnostics::UNLIMITED);
+        tokenize(input, output, diagnostics);
+        diagnostics.render(errors);
     }
 
 
@@ -1,5 +1,8 @@
 #include "parser.hpp"
-#include "parserlib.hpp"
+#include "CrossReferenceIndex.hpp"
+#include "Session.hpp"
+#include "expression.hpp"
+#include "predictive.hpp"
 
 
 namespace cap {
@@ -19,26 +22,27 @@ namespace cap {
     static auto name = terminal(TOKEN::IDENTIFIER) == AST::NAME;
 
 
-    static auto type_char = terminal(TOKEN::CHAR) == AST::TYPE_CHAR;
+    static auto type_char = lead<TOKEN::CHAR>() == AST::TYPE_CHAR;
 
 
-    static auto type_void = terminal(TOKEN::VOID) == AST::TYPE_VOID;
+    static auto type_void = lead<TOKEN::VOID>() == AST::TYPE_VOID;
 
 
-    static auto type_int = terminal(TOKEN::INT) == AST::TYPE_INT;
+    static auto type_int = lead<TOKEN::INT>() == AST::TYPE_INT;
 
 
-    static auto type_double = terminal(TOKEN::DOUBLE) == AST::TYPE_DOUBLE;
+    static auto type_double = lead<TOKEN::DOUBLE>() == AST::TYPE_DOUBLE;
 
 
-    static auto type_identifier = terminal(TOKEN::IDENTIFIER) == AST::TYPE_IDENTIFIER;
+    static auto type_identifier = lead<TOKEN::IDENTIFIER>() == AST::TYPE_IDENTIFIER;
 
 
-    static auto type_ptr_base_type = type_identifier
-                                   | type_double
-                                   | type_char
-                                   | type_void
-                                   | type_int;
+    //the base types start with distinct tokens, so the current token selects one of them
+    static auto type_ptr_base_type = predict(type_identifier,
+                                             type_double,
+                                             type_char,
+                                             type_void,
+                                             type_int);
 
 
     static rule type_ptr = (type_ptr >> terminal(TOKEN::STAR)) == AST::TYPE_PTR
@@ -48,10 +52,36 @@ namespace cap {
     static auto typename_ = type_ptr;
 
 
-    static auto enum_member = (name) == AST::ENUM_MEMBER; //TODO expression
+    static auto expression_token = terminal(TOKEN::INTEGER)
+                                 | terminal(TOKEN::FLOAT)
+                                 | terminal(TOKEN::STRING)
+                                 | terminal(TOKEN::CHARACTER)
+                                 | terminal(TOKEN::IDENTIFIER)
+                                 | terminal(TOKEN::OPENING_PARENTHESIS)
+                                 | terminal(TOKEN::CLOSING_PARENTHESIS)
+                                 | terminal(TOKEN::PLUS)
+                                 | terminal(TOKEN::MINUS)
+                                 | terminal(TOKEN::STAR)
+                                 | terminal(TOKEN::SLASH)
+                                 | terminal(TOKEN::PERCENT)
+                                 | terminal(TOKEN::LESS_THAN)
+                                 | terminal(TOKEN::GREATER_THAN)
+                                 | terminal(TOKEN::AMBERSAND)
+                                 | terminal(TOKEN::VERTICAL_BAR)
+                                 | terminal(TOKEN::CARET)
+                                 | terminal(TOKEN::TILDE)
+                                 | terminal(TOKEN::EXCLAMATION_MARK);
 
 
-    static auto enum_ = (terminal(TOKEN::ENUM) >> 
+    //the grammar only delimits an expression; its structure is built by parse_expression,
+    //so operator precedence costs no backtracking here
+    static auto expression = (+expression_token) == AST::EXPRESSION;
+
+
+    static auto enum_member = (name >> -(terminal(TOKEN::EQUALS) >> expression)) == AST::ENUM_MEMBER;
+
+
+    static auto enum_ = (lead<TOKEN::ENUM>() >> 
                         name >>
                         terminal(TOKEN::OPENING_CURLY_BRACKET) >> 
                         -(enum_member >> *(terminal(TOKEN::COMMA) >> enum_member)) >>
@@ -60,29 +90,55 @@ namespace cap {
 
     static auto struct_member = (typename_ >> 
                                 name >>
-                                terminal(TOKEN::SEMICOLON)) == AST::STRUCT_MEMBER; //TODO init expression
+                                -(terminal(TOKEN::EQUALS) >> expression) >>
+                                terminal(TOKEN::SEMICOLON)) == AST::STRUCT_MEMBER;
 
 
-    static auto struct_ = (terminal(TOKEN::STRUCT) >>
+    static auto struct_ = (lead<TOKEN::STRUCT>() >>
                           name >>
                           terminal(TOKEN::OPENING_CURLY_BRACKET) >>
                           *struct_member >>
                           terminal(TOKEN::CLOSING_CURLY_BRACKET)) == AST::STRUCT;
 
 
-    static auto typedef_ = (terminal(TOKEN::TYPEDEF) >>
+    static auto typedef_ = (lead<TOKEN::TYPEDEF>() >>
                            typename_ >>
                            name) == AST::TYPEDEF;
 
 
-    static auto declaration = enum_
-                            | struct_
-                            | typedef_;
+    static auto import_ = (lead<TOKEN::IMPORT>() >>
+                          terminal(TOKEN::STRING) >>
+                          terminal(TOKEN::SEMICOLON)) == AST::IMPORT;
+
+
+    //each declaration starts with its own keyword; the alternatives keep the order of the
+    //ordered choice they replace, which GrammarStatistics::avoided is measured against
+    static auto declaration = predict(enum_,
+                                      struct_,
+                                      typedef_,
+                                      import_);
 
 
     static auto grammar = *declaration;
 
 
+    //grammar statistics
+    GrammarStatistics& grammar_statistics() {
+        static thread_local GrammarStatistics statistics;
+        return statistics;
+    }
+
+
+    //grammar statistics enabled; the counters are instantiated with the grammar, in this file
+    bool grammar_statistics_enabled() {
+#ifdef CAP_GRAMMAR_STATISTICS
+        return true;
+#else
+        return false;
+#endif
+    }
+
+
     /**************************************************************************
        PARSER
      **************************************************************************/
@@ -92,144 +148,389 @@ namespace cap {
     using ParseIterator = typename std::vector<parse_context::match>::const_iterator;
 
 
-    template <class T> std::shared_ptr<T> pop_node(const ParseIterator& it, ASTNodeStack& stack, const char* tag) {
-        if (stack.empty()) {
-            throw Error{it->begin->position, std::string("Expected ") + tag};
+    /**
+     * State shared by the AST construction functions.
+     */
+    struct ParseState {
+        ASTNodeStack& stack;
+        Diagnostics& diagnostics;
+        NodeAllocator<ASTNode> allocator;
+
+        //optional collection of type name definitions and references
+        FileSymbols* symbols;
+
+        //enum members defined so far, for folding expressions that refer to them
+        ConstantTable constants;
+
+        //value of the next enum member without an explicit value
+        int64_t nextEnumValue = 0;
+
+        ParseState(ASTNodeStack& stack, Diagnostics& diagnostics, const NodeAllocator<ASTNode>& allocator, FileSymbols* symbols)
+            : stack(stack)
+            , diagnostics(diagnostics)
+            , allocator(allocator)
+            , symbols(symbols)
+        {
+        }
+    };
+
+
+    //nodes are positioned at their first token
+    template <class T> std::shared_ptr<T> make_node(const ParseIterator& it, ParseState& state) {
+        std::shared_ptr<T> result = allocate_node<T>(state.allocator);
+        result->position = it->begin->position;
+        return result;
+    }
+
+
+    template <class T> std::shared_ptr<T> pop_node(const ParseIterator& it, ParseState& state, const char* tag) {
+        if (state.stack.empty()) {
+            state.diagnostics.report(DIAGNOSTIC::EXPECTED, it->begin->position, tag);
+            return nullptr;
         }
         
-        std::shared_ptr<T> result = std::dynamic_pointer_cast<T>(stack.back());
+        std::shared_ptr<T> result = std::dynamic_pointer_cast<T>(state.stack.back());
         if (!result) {
-            throw Error{ it->begin->position, std::string("Expected ") + tag };
+            state.diagnostics.report(DIAGNOSTIC::EXPECTED, it->begin->position, tag);
+            return nullptr;
         }
 
-        stack.pop_back();
+        state.stack.pop_back();
         return result;
     }
 
 
-    template <class T> std::shared_ptr<T> pop_node_opt(const ParseIterator& it, ASTNodeStack& stack, const char* tag) {
-        if (stack.empty()) {
-            throw Error{ it->begin->position, std::string("Expected ") + tag };
-        }
-
-        std::shared_ptr<T> result = std::dynamic_pointer_cast<T>(stack.back());
-        if (!result) {
+    template <class T> std::shared_ptr<T> pop_node_opt(ParseState& state) {
+        if (state.stack.empty() || !dynamic_cast<T*>(state.stack.back().get())) {
             return nullptr;
         }
 
-        stack.pop_back();
+        std::shared_ptr<T> result = std::static_pointer_cast<T>(std::move(state.stack.back()));
+        state.stack.pop_back();
         return result;
     }
 
 
-    template <class T> std::vector<std::shared_ptr<T>> pop_vector(const ParseIterator& it, ASTNodeStack& stack, const char* tag) {
-        std::vector<std::shared_ptr<T>> result;
-        while (auto elem = pop_node_opt<T>(it, stack, tag)) {
-            result.push_back(elem);
+    template <class T> bool pop_vector(const ParseIterator& it, ParseState& state, const char* tag, std::vector<std::shared_ptr<T>>& output) {
+        //count the consecutive T nodes on top of the stack
+        size_t count = 0;
+        for (auto node = state.stack.rbegin(); ; ++node, ++count) {
+            if (node == state.stack.rend()) {
+                state.diagnostics.report(DIAGNOSTIC::EXPECTED, it->begin->position, tag);
+                return false;
+            }
+            if (!dynamic_cast<T*>(node->get())) {
+                break;
+            }
+        }
+
+        //move them, in order, to the output
+        output.reserve(count);
+        for (auto node = state.stack.end() - count; node != state.stack.end(); ++node) {
+            output.push_back(std::static_pointer_cast<T>(std::move(*node)));
         }
-        return {result.rbegin(), result.rend()};
+        state.stack.resize(state.stack.size() - count);
+        return true;
     }
 
 
-    static void create_ast_type_void(const ParseIterator& it, ASTNodeStack& stack) {
-        stack.push_back(std::make_shared<ASTTypeVoid>());
+    static bool create_ast_type_void(const ParseIterator& it, ParseState& state) {
+        state.stack.push_back(make_node<ASTTypeVoid>(it, state));
+        return true;
     }
 
 
-    static void create_ast_type_char(const ParseIterator& it, ASTNodeStack& stack) {
-        stack.push_back(std::make_shared<ASTTypeChar>());
+    static bool create_ast_type_char(const ParseIterator& it, ParseState& state) {
+        state.stack.push_back(make_node<ASTTypeChar>(it, state));
+        return true;
     }
 
 
-    static void create_ast_type_int(const ParseIterator& it, ASTNodeStack& stack) {
-        stack.push_back(std::make_shared<ASTTypeInt>());
+    static bool create_ast_type_int(const ParseIterator& it, ParseState& state) {
+        state.stack.push_back(make_node<ASTTypeInt>(it, state));
+        return true;
     }
 
 
-    static void create_ast_type_double(const ParseIterator& it, ASTNodeStack& stack) {
-        stack.push_back(std::make_shared<ASTTypeDouble>());
+    static bool create_ast_type_double(const ParseIterator& it, ParseState& state) {
+        state.stack.push_back(make_node<ASTTypeDouble>(it, state));
+        return true;
     }
 
 
-    static void create_ast_type_identifier(const ParseIterator& it, ASTNodeStack& stack) {
-        std::shared_ptr<ASTTypeIdentifier> result = std::make_shared<ASTTypeIdentifier>();
+    static bool create_ast_type_identifier(const ParseIterator& it, ParseState& state) {
+        std::shared_ptr<ASTTypeIdentifier> result = make_node<ASTTypeIdentifier>(it, state);
 
         result->name = it->begin->content;
 
-        stack.push_back(result);
+        if (state.symbols) {
+            state.symbols->reference(result->name, result->position);
+        }
+
+        state.stack.push_back(result);
+        return true;
     }
 
 
-    static void create_ast_type_ptr(const ParseIterator& it, ASTNodeStack& stack) {
-        std::shared_ptr<ASTTypePtr> result = std::make_shared<ASTTypePtr>();
+    static bool create_ast_type_ptr(const ParseIterator& it, ParseState& state) {
+        std::shared_ptr<ASTTypePtr> result = make_node<ASTTypePtr>(it, state);
 
-        result->baseType = pop_node<ASTTypename>(it, stack, "base type");
+        result->baseType = pop_node<ASTTypename>(it, state, "base type");
+        if (!result->baseType) {
+            return false;
+        }
 
-        stack.push_back(result);
+        state.stack.push_back(result);
+        return true;
     }
 
 
-    static void create_ast_name(const ParseIterator& it, ASTNodeStack& stack) {
-        std::shared_ptr<ASTName> result{std::make_shared<ASTName>()};
+    static bool create_ast_name(const ParseIterator& it, ParseState& state) {
+        std::shared_ptr<ASTName> result{make_node<ASTName>(it, state)};
 
         result->value = it->begin->content;
         
-        stack.push_back(result);
+        state.stack.push_back(result);
+        return true;
+    }
+
+
+    static bool create_ast_expression(const ParseIterator& it, ParseState& state) {
+        std::shared_ptr<ASTExpression> result = parse_expression(it->begin, it->end, state.constants, state.diagnostics, state.allocator);
+
+        //the errors are reported; the declaration keeps a placeholder, and parsing goes on
+        if (!result) {
+            result = make_node<ASTErrorExpression>(it, state);
+        }
+
+        state.stack.push_back(result);
+        return true;
     }
 
 
-    static void create_ast_enum_member(const ParseIterator& it, ASTNodeStack& stack) {
-        std::shared_ptr<ASTEnumMember> result{ std::make_shared<ASTEnumMember>() };        
+    static bool create_ast_enum_member(const ParseIterator& it, ParseState& state) {
+        std::shared_ptr<ASTEnumMember> result{ make_node<ASTEnumMember>(it, state) };        
+
+        result->expression = pop_node_opt<ASTExpression>(state);
+        const auto name = pop_node<ASTName>(it, state, "enum member name");
+        if (!name) {
+            return false;
+        }
+        result->name = name->value;
 
-        result->name = pop_node<ASTName>(it, stack, "enum member name")->value;
-        //TODO enum member expression.
+        //the value is either explicit and constant, or the previous value plus one;
+        //a value in error counts as implicit, so that the following members keep theirs
+        if (result->expression && result->expression->constant) {
+            result->value = result->expression->value;
+        }
+        else {
+            if (result->expression && !dynamic_cast<const ASTErrorExpression*>(result->expression.get())) {
+                state.diagnostics.report(DIAGNOSTIC::NOT_CONSTANT, result->expression->position, result->name);
+            }
+            result->value = state.nextEnumValue;
+        }
+        state.nextEnumValue = static_cast<int64_t>(static_cast<uint64_t>(result->value) + 1);
+
+        //a redefinition is reported; expressions keep seeing the first definition
+        if (!state.constants.emplace(result->name, result->value).second) {
+            state.diagnostics.report(DIAGNOSTIC::CONSTANT_REDEFINED, result->position, result->name);
+        }
         
-        stack.push_back(result);
+        state.stack.push_back(result);
+        return true;
     }
 
 
-    static void create_ast_enum(const ParseIterator& it, ASTNodeStack& stack) {
-        std::shared_ptr<ASTEnum> result{ std::make_shared<ASTEnum>() };
+    static bool create_ast_enum(const ParseIterator& it, ParseState& state) {
+        std::shared_ptr<ASTEnum> result{ make_node<ASTEnum>(it, state) };
+
+        //the next enum starts counting from zero
+        state.nextEnumValue = 0;
         
-        result->members = pop_vector<ASTEnumMember>(it, stack, "enum member");        
-        result->name = pop_node<ASTName>(it, stack, "enum name")->value;
+        if (!pop_vector<ASTEnumMember>(it, state, "enum member", result->members)) {
+            return false;
+        }
+        const auto name = pop_node<ASTName>(it, state, "enum name");
+        if (!name) {
+            return false;
+        }
+        result->name = name->value;
+
+        if (state.symbols) {
+            state.symbols->define(name->value, name->position);
+        }
+
+        state.stack.push_back(result);
+        return true;
+    }
+
 
-        stack.push_back(result);
+    static bool create_ast_struct_member(const ParseIterator& it, ParseState& state) {
+        std::shared_ptr<ASTStructMember> result{ make_node<ASTStructMember>(it, state) };
+
+        result->initializer = pop_node_opt<ASTExpression>(state);
+        const auto name = pop_node<ASTName>(it, state, "struct member name");
+        if (!name) {
+            return false;
+        }
+        result->name = name->value;
+        result->typename_ = pop_node<ASTTypename>(it, state, "struct member type");
+        if (!result->typename_) {
+            return false;
+        }
+
+        state.stack.push_back(result);
+        return true;
     }
 
 
-    static void create_ast_struct_member(const ParseIterator& it, ASTNodeStack& stack) {
-        std::shared_ptr<ASTStructMember> result{ std::make_shared<ASTStructMember>() };
+    static bool create_ast_struct(const ParseIterator& it, ParseState& state) {
+        std::shared_ptr<ASTStruct> result{ make_node<ASTStruct>(it, state) };
 
-        //TODO enum member expression.
-        result->name = pop_node<ASTName>(it, stack, "struct member name")->value;
-        result->typename_ = pop_node<ASTTypename>(it, stack, "struct member type");
+        if (!pop_vector<ASTStructMember>(it, state, "struct member", result->members)) {
+            return false;
+        }
+        const auto name = pop_node<ASTName>(it, state, "struct name");
+        if (!name) {
+            return false;
+        }
+        result->name = name->value;
+
+        if (state.symbols) {
+            state.symbols->define(name->value, name->position);
+        }
 
-        stack.push_back(result);
+        state.stack.push_back(result);
+        return true;
     }
 
 
-    static void create_ast_struct(const ParseIterator& it, ASTNodeStack& stack) {
-        std::shared_ptr<ASTStruct> result{ std::make_shared<ASTStruct>() };
+    static bool create_ast_typedef(const ParseIterator& it, ParseState& state) {
+        std::shared_ptr<ASTTypedef> result{ make_node<ASTTypedef>(it, state) };
 
-        result->members = pop_vector<ASTStructMember>(it, stack, "struct member");
-        result->name = pop_node<ASTName>(it, stack, "struct name")->value;
+        const auto name = pop_node<ASTName>(it, state, "typedef name");
+        if (!name) {
+            return false;
+        }
+        result->name = name->value;
+
+        if (state.symbols) {
+            state.symbols->define(name->value, name->position);
+        }
+        result->type = pop_node<ASTTypename>(it, state, "typedef type");
+        if (!result->type) {
+            return false;
+        }
 
-        stack.push_back(result);
+        state.stack.push_back(result);
+        return true;
     }
 
 
-    static void create_ast_typedef(const ParseIterator& it, ASTNodeStack& stack) {
-        std::shared_ptr<ASTTypedef> result{ std::make_shared<ASTTypedef>() };
+    static bool create_ast_import(const ParseIterator& it, ParseState& state) {
+        std::shared_ptr<ASTImport> result{ make_node<ASTImport>(it, state) };
 
-        result->name = pop_node<ASTName>(it, stack, "typedef name")->value;
-        result->type = pop_node<ASTTypename>(it, stack, "typedef type");
+        //the string token follows the keyword; strip its quotes
+        const std::string_view path = (it->begin + 1)->content;
+        result->path = path.substr(1, path.size() - 2);
 
-        stack.push_back(result);
+        state.stack.push_back(result);
+        return true;
     }
 
 
-    void parse(const std::vector<Token>& input, std::vector<ASTNodePtr>& output, std::vector<Error>& errors) {
+    //create the AST nodes of the matches, accounting their memory if requested; returns false on the first structural error;
+    //errors in expressions and enum values are reported without stopping
+    static bool create_ast(const std::vector<parse_context::match>& matches, ParseState& state, const AllocationCounter& counting, MemoryStatistics* statistics) {
+        //process matches; stop at the first structural error
+        bool valid = true;
+        for (auto it = matches.begin(); valid && it != matches.end(); ++it) {
+            const size_t bytes = counting.bytes;
+            const size_t allocations = counting.allocations;
+
+            switch (it->tag) {
+                case AST::TYPE_VOID:
+                    valid = create_ast_type_void(it, state);
+                    break;
+
+                case AST::TYPE_CHAR:
+                    valid = create_ast_type_char(it, state);
+                    break;
+
+                case AST::TYPE_INT:
+                    valid = create_ast_type_int(it, state);
+                    break;
+
+                case AST::TYPE_DOUBLE:
+                    valid = create_ast_type_double(it, state);
+                    break;
+
+                case AST::TYPE_IDENTIFIER:
+                    valid = create_ast_type_identifier(it, state);
+                    break;
+
+                case AST::TYPE_PTR:
+                    valid = create_ast_type_ptr(it, state);
+                    break;
+
+                case AST::NAME:
+                    valid = create_ast_name(it, state);
+                    break;
+
+                case AST::EXPRESSION:
+                    valid = create_ast_expression(it, state);
+                    break;
+
+                case AST::ENUM_MEMBER: 
+                    valid = create_ast_enum_member(it, state);
+                    break;
+
+                case AST::ENUM: 
+                    valid = create_ast_enum(it, state);
+                    break;
+
+                case AST::STRUCT_MEMBER:
+                    valid = create_ast_struct_member(it, state);
+                    break;
+
+                case AST::STRUCT:
+                    valid = create_ast_struct(it, state);
+                    break;
+
+                case AST::TYPEDEF:
+                    valid = create_ast_typedef(it, state);
+                    break;
+
+                case AST::IMPORT:
+                    valid = create_ast_import(it, state);
+                    break;
+
+                default:
+                    state.diagnostics.report(DIAGNOSTIC::INVALID_DECLARATION, it->begin->position);
+                    valid = false;
+                    break;
+
+            }
+
+            if (statistics && counting.allocations > allocations) {
+                statistics->ast(it->tag).allocate(counting.bytes - bytes, counting.allocations - allocations);
+                (*statistics)[PHASE::AST].allocate(counting.bytes - bytes, counting.allocations - allocations);
+                statistics->astNodes += counting.allocations - allocations;
+            }
+        }
+
+        //account the match list, which is freed on return
+        if (statistics && matches.capacity() > 0) {
+            const size_t matchBytes = matches.capacity() * sizeof(matches[0]);
+            (*statistics)[PHASE::MATCHES].allocate(matchBytes);
+            (*statistics)[PHASE::MATCHES].deallocate(matchBytes);
+        }
+
+        return valid;
+    }
+
+
+    static void parse_tokens(const std::vector<Token>& input, std::vector<ASTNodePtr>& output, Diagnostics& diagnostics, std::pmr::memory_resource* resource, MemoryStatistics* statistics, FileSymbols* symbols) {
         //reset the output variable
         output.clear();
 
@@ -237,71 +538,82 @@ namespace cap {
         auto pc = parse_context(input);
 
         //parse 
-        const bool ok = parse(grammar, pc);
+        parse(grammar, pc);
 
-        //process matches
-        try {
-            for (auto it = pc.matches.begin(); it != pc.matches.end(); ++it) {
-                switch (it->tag) {
-                    case AST::TYPE_VOID:
-                        create_ast_type_void(it, output);
-                        break;
+        //when accounting, node allocations are counted on their way to the resource
+        AllocationCounter counting;
 
-                    case AST::TYPE_CHAR:
-                        create_ast_type_char(it, output);
-                        break;
+        //the output doubles as the construction stack
+        ParseState state(output, diagnostics, NodeAllocator<ASTNode>(resource, statistics ? &counting : nullptr), symbols);
 
-                    case AST::TYPE_INT:
-                        create_ast_type_int(it, output);
-                        break;
+        create_ast(pc.matches, state, counting, statistics);
+    }
 
-                    case AST::TYPE_DOUBLE:
-                        create_ast_type_double(it, output);
-                        break;
 
-                    case AST::TYPE_IDENTIFIER:
-                        create_ast_type_identifier(it, output);
-                        break;
+    /**
+     * State of a declaration parser.
+     */
+    struct DeclarationParser::State {
+        AllocationCounter counting;
+        ParseState parseState;
+        MemoryStatistics* statistics;
+        bool failed = false;
+
+        State(std::vector<ASTNodePtr>& output, Diagnostics& diagnostics, std::pmr::memory_resource* resource, MemoryStatistics* statistics, FileSymbols* symbols)
+            : parseState(output, diagnostics, NodeAllocator<ASTNode>(resource, statistics ? &counting : nullptr), symbols)
+            , statistics(statistics)
+        {
+        }
+    };
 
-                    case AST::TYPE_PTR:
-                        create_ast_type_ptr(it, output);
-                        break;
 
-                    case AST::NAME:
-                        create_ast_name(it, output);
-                        break;
+    //constructor
+    DeclarationParser::DeclarationParser(std::vector<ASTNodePtr>& output, Diagnostics& diagnostics, std::pmr::memory_resource* resource, MemoryStatistics* statistics, FileSymbols* symbols)
+        : m_state(std::make_unique<State>(output, diagnostics, resource, statistics, symbols))
+    {
+    }
 
-                    case AST::ENUM_MEMBER: 
-                        create_ast_enum_member(it, output);
-                        break;
 
-                    case AST::ENUM: 
-                        create_ast_enum(it, output);
-                        break;
+    //destructor
+    DeclarationParser::~DeclarationParser() {
+    }
 
-                    case AST::STRUCT_MEMBER:
-                        create_ast_struct_member(it, output);
-                        break;
 
-                    case AST::STRUCT:
-                        create_ast_struct(it, output);
-                        break;
+    //parse one declaration
+    bool DeclarationParser::parse(const std::vector<Token>& tokens) {
+        if (m_state->failed || tokens.empty()) {
+            return !m_state->failed;
+        }
 
-                    case AST::TYPEDEF:
-                        create_ast_typedef(it, output);
-                        break;
+        auto pc = parse_context(tokens);
+        parserlib::parse(grammar, pc);
 
-                    default:
-                        throw Error{ it->begin->position, "Invalid declaration" };
+        //the declaration's own match comes after those of its parts; if it does not end
+        //with the tokens, whole-input parsing would stop here, so this parser stops too
+        const bool complete = !pc.matches.empty() && pc.matches.back().end == tokens.end();
 
-                }
-            }
-        }
-        catch (const Error& error) {
-            errors.push_back(error);
+        if (!create_ast(pc.matches, m_state->parseState, m_state->counting, m_state->statistics) || !complete) {
+            m_state->failed = true;
         }
 
-        int x = 0;
+        return !m_state->failed;
+    }
+
+
+    void parse(const std::vector<Token>& input, std::vector<ASTNodePtr>& output, Diagnostics& diagnostics, MemoryStatistics* statistics, FileSymbols* symbols) {
+        parse_tokens(input, output, diagnostics, std::pmr::new_delete_resource(), statistics, symbols);
+    }
+
+
+    void parse(Session& session, Diagnostics& diagnostics) {
+        parse_tokens(session.tokens, session.ast, diagnostics, session.resource(), session.statistics, session.symbols);
+    }
+
+
+    void parse(const std::vector<Token>& input, std::vector<ASTNodePtr>& output, std::vector<Error>& errors) {
+        Diagnostics diagnostics(Diagnostics::UNLIMITED);
+        parse(input, output, diagnostics);
+        diagnostics.render(errors);
     }
 
 
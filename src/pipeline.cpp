@@ -0,0 +1,291 @@
+#include "pipeline.hpp"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <exception>
+#include <memory>
+#include <thread>
+#include "RingBuffer.hpp"
+#include "ThreadPool.hpp"
+#include "unicode.hpp"
+
+
+namespace cap {
+
+
+    //number of token batches in flight between the lexer and the parser
+    static constexpr size_t PIPELINE_BATCHES = 16;
+
+
+    using TokenRing = RingBuffer<std::vector<Token>, PIPELINE_BATCHES>;
+
+
+    //bytes at which the chunk scanner may change state
+    static constexpr std::array<bool, 256> make_scanner_table() {
+        std::array<bool, 256> result{};
+        result['\n'] = true;
+        result['/'] = true;
+        result['"'] = true;
+        result['\''] = true;
+        return result;
+    }
+
+
+    static constexpr std::array<bool, 256> scannerTable = make_scanner_table();
+
+
+    //end of the chunk that starts at begin: the first line end at or after target that is not inside
+    //a comment, a string or a character literal; begin must not be inside one either
+    static size_t find_chunk_end(const std::string& input, size_t begin, size_t target) {
+        const char* const data = input.data();
+        const size_t size = input.size();
+
+        for (size_t i = begin; i < size; ) {
+            //skip ordinary bytes
+            if (!scannerTable[static_cast<unsigned char>(data[i])]) {
+                ++i;
+                continue;
+            }
+
+            const char c = data[i];
+
+            if (c == '\n') {
+                ++i;
+                if (i >= target) {
+                    return i;
+                }
+            }
+
+            //an unterminated comment or string is lexed as separate tokens, but treating it as
+            //extending to the end of the input only costs the remaining splits
+            else if (c == '/' && i + 1 < size && data[i + 1] == '*') {
+                const size_t end = input.find("*/", i + 2);
+                i = end == std::string::npos ? size : end + 2;
+            }
+
+            //the line end of a line comment is a split point
+            else if (c == '/' && i + 1 < size && data[i + 1] == '/') {
+                const size_t end = input.find('\n', i + 2);
+                i = end == std::string::npos ? size : end;
+            }
+
+            else if (c == '"') {
+                const size_t end = input.find('"', i + 1);
+                i = end == std::string::npos ? size : end + 1;
+            }
+
+            //a character literal is exactly one byte between quotes; that byte may be a line end
+            else if (c == '\'' && i + 2 < size && data[i + 1] != '\'' && data[i + 2] == '\'') {
+                i += 3;
+            }
+
+            else {
+                ++i;
+            }
+        }
+
+        return size;
+    }
+
+
+    //lex the input chunk by chunk into the ring; stops after the first chunk with a syntax error, like tokenize
+    static void produce_tokens(const std::string& input, TokenRing& ring, Diagnostics& diagnostics) {
+        std::string buffer;
+        int line = 1;
+
+        for (size_t begin = 0; begin < input.size(); ) {
+            const size_t end = find_chunk_end(input, begin, begin + PIPELINE_CHUNK_SIZE);
+
+            std::vector<Token> batch;
+            const bool ok = tokenize_range(input, begin, end, line, buffer, batch, diagnostics);
+            ring.push(std::move(batch));
+            if (!ok) {
+                break;
+            }
+
+            line += static_cast<int>(std::count(input.begin() + begin, input.begin() + end, '\n'));
+            begin = end;
+        }
+    }
+
+
+    //tokens that start a declaration
+    static bool is_declaration_keyword(TOKEN token) {
+        return token == TOKEN::IMPORT || token == TOKEN::ENUM || token == TOKEN::STRUCT || token == TOKEN::TYPEDEF;
+    }
+
+
+    //feed the tokens to the parser one declaration at a time; the declaration being collected
+    //is kept, since its end is only known when the next keyword arrives
+    static void parse_declarations(const std::vector<Token>& tokens, std::vector<Token>& declaration, DeclarationParser& parser) {
+        for (const Token& token : tokens) {
+            if (is_declaration_keyword(token.token) && !declaration.empty()) {
+                parser.parse(declaration);
+                declaration.clear();
+            }
+            declaration.push_back(token);
+        }
+    }
+
+
+    //parse the token batches as they arrive
+    static void consume_tokens(TokenRing& ring, std::vector<Token>& tokens, DeclarationParser& parser) {
+        std::vector<Token> batch;
+        std::vector<Token> declaration;
+
+        while (ring.pop(batch)) {
+            parse_declarations(batch, declaration, parser);
+            tokens.insert(tokens.end(), batch.begin(), batch.end());
+        }
+
+        parser.parse(declaration);
+    }
+
+
+    /**
+     * Lexer side of a pipeline. It is shared with the lexer task, which may start after the parser
+     * has given up on it, and which still touches the ring after closing it.
+     */
+    struct LexerStage {
+        const std::string& input;
+        TokenRing ring;
+
+        //the limit is applied when the diagnostics are transferred, after they are put in order
+        Diagnostics diagnostics{ Diagnostics::UNLIMITED };
+
+        std::exception_ptr error;
+
+        //set by whichever side lexes the input: the lexer task, or the parser when the task is late
+        std::atomic<bool> claimed{ false };
+
+        explicit LexerStage(const std::string& input) : input(input) {
+        }
+
+        void run() {
+            try {
+                produce_tokens(input, ring, diagnostics);
+            }
+            catch (...) {
+                error = std::current_exception();
+            }
+            ring.close();
+        }
+    };
+
+
+    //start the lexer stage on the pool, or on a thread of its own; returns false if the caller must lex
+    static bool start_lexer(const std::shared_ptr<LexerStage>& stage, ThreadPool* pool, std::thread& thread) {
+        if (!pool) {
+            stage->claimed.store(true, std::memory_order_relaxed);
+            thread = std::thread([stage]() { stage->run(); });
+            return true;
+        }
+
+        pool->submit([stage]() {
+            if (!stage->claimed.exchange(true)) {
+                stage->run();
+            }
+        });
+
+        //a worker that is idle picks the task up at once; if none did, all of them are busy,
+        //so lexing here costs no throughput, while waiting for a worker would cost latency
+        const auto startTime = std::chrono::steady_clock::now();
+        while (!stage->claimed.load(std::memory_order_relaxed)) {
+            if (std::chrono::steady_clock::now() - startTime >= PIPELINE_START_TIMEOUT) {
+                return stage->claimed.exchange(true);
+            }
+            std::this_thread::yield();
+        }
+        return true;
+    }
+
+
+    //tokenize, then parse one declaration at a time, like the pipeline does
+    static void tokenize_and_parse_sequentially(const std::string& input, std::vector<Token>& tokens, std::vector<ASTNodePtr>& ast, Diagnostics& diagnostics, std::pmr::memory_resource* resource, MemoryStatistics* statistics, FileSymbols* symbols) {
+        tokenize(input, tokens, diagnostics, statistics);
+        DeclarationParser parser(ast, diagnostics, resource, statistics, symbols);
+        std::vector<Token> declaration;
+        parse_declarations(tokens, declaration, parser);
+        parser.parse(declaration);
+    }
+
+
+    //tokenize and parse
+    void tokenize_and_parse(const std::string& input, std::vector<Token>& tokens, std::vector<ASTNodePtr>& ast, Diagnostics& diagnostics, std::pmr::memory_resource* resource, MemoryStatistics* statistics, FileSymbols* symbols, ThreadPool* pool) {
+        ast.clear();
+
+        //a single chunk gains nothing from a second thread
+        if (input.size() <= PIPELINE_CHUNK_SIZE) {
+            tokenize_and_parse_sequentially(input, tokens, ast, diagnostics, resource, statistics, symbols);
+            return;
+        }
+
+        const std::shared_ptr<LexerStage> stage = std::make_shared<LexerStage>(input);
+        std::thread lexer;
+
+        if (!start_lexer(stage, pool, lexer)) {
+            tokenize_and_parse_sequentially(input, tokens, ast, diagnostics, resource, statistics, symbols);
+            return;
+        }
+
+        tokens.clear();
+        const size_t tokensCapacity = tokens.capacity();
+
+        //the encoding is validated up front, so that its diagnostics come first, as with tokenize
+        validate_utf8(input, diagnostics);
+
+        //the parser reports into its own diagnostics; they are merged in sequential order at the end.
+        //Sequentially, the parser's reports would share the limit with the lexer's, so whatever
+        //this collection drops would have been dropped too; the transfer counts it as such
+        Diagnostics parserDiagnostics(diagnostics.limit(), diagnostics.file());
+
+        std::exception_ptr parserError;
+
+        try {
+            DeclarationParser parser(ast, parserDiagnostics, resource, statistics, symbols);
+            consume_tokens(stage->ring, tokens, parser);
+        }
+        catch (...) {
+            parserError = std::current_exception();
+
+            //unblock the lexer
+            std::vector<Token> batch;
+            while (stage->ring.pop(batch)) {
+            }
+        }
+
+        //the ring is closed and drained, so the lexer is done with the input and its diagnostics
+        if (lexer.joinable()) {
+            lexer.join();
+        }
+
+        if (stage->error) {
+            std::rethrow_exception(stage->error);
+        }
+        if (parserError) {
+            std::rethrow_exception(parserError);
+        }
+
+        //tokenize reports the syntax error of the whole input before the identifier checks,
+        //while the chunks report theirs in turn; the lexer stops at its only syntax error
+        stage->diagnostics.sort([](const Diagnostic& a, const Diagnostic& b) {
+            return a.id == DIAGNOSTIC::SYNTAX_ERROR && b.id != DIAGNOSTIC::SYNTAX_ERROR;
+        });
+
+        diagnostics.transfer(stage->diagnostics);
+        diagnostics.transfer(parserDiagnostics);
+
+        if (statistics) {
+            (*statistics)[PHASE::TOKENS].reallocate(tokensCapacity * sizeof(Token), tokens.capacity() * sizeof(Token));
+            statistics->tokens += tokens.size();
+        }
+    }
+
+
+    //tokenize and parse a session
+    void tokenize_and_parse(Session& session, Diagnostics& diagnostics, ThreadPool* pool) {
+        tokenize_and_parse(session.source, session.tokens, session.ast, diagnostics, session.resource(), session.statistics, session.symbols, pool);
+    }
+
+
+} //namespace cap
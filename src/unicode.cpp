@@ -0,0 +1,370 @@
+#include "unicode.hpp"
+#include <algorithm>
+#include <cstdint>
+
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define CAP_UTF8_SSSE3
+#define CAP_TARGET_SSSE3 __attribute__((target("ssse3")))
+#elif defined(_MSC_VER) && defined(_M_X64)
+#include <intrin.h>
+#define CAP_UTF8_SSSE3
+#define CAP_TARGET_SSSE3
+#endif
+
+
+namespace cap {
+
+
+    /**************************************************************************
+       SCALAR VALIDATION
+     **************************************************************************/
+
+
+    static bool is_continuation(uint8_t byte, uint8_t min = 0x80, uint8_t max = 0xBF) {
+        return byte >= min && byte <= max;
+    }
+
+
+    //decode, following the well-formed byte sequences of RFC 3629
+    size_t decode_utf8(const char* data, size_t size, char32_t& codePoint, bool& valid) {
+        const uint8_t* bytes = reinterpret_cast<const uint8_t*>(data);
+        const uint8_t lead = bytes[0];
+
+        if (lead < 0x80) {
+            codePoint = lead;
+            valid = true;
+            return 1;
+        }
+
+        size_t length;
+        uint8_t min = 0x80;
+        uint8_t max = 0xBF;
+        char32_t result;
+
+        if (lead >= 0xC2 && lead <= 0xDF) {
+            length = 2;
+            result = lead & 0x1F;
+        }
+        else if (lead >= 0xE0 && lead <= 0xEF) {
+            length = 3;
+            result = lead & 0x0F;
+            if (lead == 0xE0) {
+                min = 0xA0;
+            }
+            else if (lead == 0xED) {
+                max = 0x9F;
+            }
+        }
+        else if (lead >= 0xF0 && lead <= 0xF4) {
+            length = 4;
+            result = lead & 0x07;
+            if (lead == 0xF0) {
+                min = 0x90;
+            }
+            else if (lead == 0xF4) {
+                max = 0x8F;
+            }
+        }
+        else {
+            valid = false;
+            return 1;
+        }
+
+        //only the second byte has a restricted range
+        for (size_t index = 1; index < length; ++index) {
+            if (index == size || !is_continuation(bytes[index], index == 1 ? min : 0x80, index == 1 ? max : 0xBF)) {
+                valid = false;
+                return index;
+            }
+            result = (result << 6) | (bytes[index] & 0x3F);
+        }
+
+        codePoint = result;
+        valid = true;
+        return length;
+    }
+
+
+    //find the first malformed sequence, one sequence at a time
+    static size_t find_invalid_scalar(const uint8_t* data, size_t size, bool& ascii) {
+        size_t offset = 0;
+        while (offset < size) {
+            if (data[offset] < 0x80) {
+                ++offset;
+                continue;
+            }
+            ascii = false;
+            char32_t codePoint;
+            bool valid;
+            const size_t length = decode_utf8(reinterpret_cast<const char*>(data + offset), size - offset, codePoint, valid);
+            if (!valid) {
+                return offset;
+            }
+            offset += length;
+        }
+        return size;
+    }
+
+
+    //a sequence boundary from which the scalar validator can resume a block that starts at the given offset;
+    //the block before it is known to be valid up to a possibly incomplete last sequence
+    static size_t restart_offset(const uint8_t* data, size_t offset) {
+        if (offset < 64) {
+            return 0;
+        }
+        offset -= 64;
+        for (size_t back = 0; back < 3 && offset > 0 && (data[offset] & 0xC0) == 0x80; ++back) {
+            --offset;
+        }
+        return offset;
+    }
+
+
+    /**************************************************************************
+       VECTORISED VALIDATION
+
+       The lookup algorithm of Keiser and Lemire ("Validating UTF-8 in less
+       than one instruction per byte"): each byte is classified through three
+       16-entry tables indexed by nibbles of it and of the previous byte; the
+       tables' AND is non-zero exactly where a two-byte error occurs, and the
+       3rd/4th byte requirements are checked with saturating subtractions.
+       A block of 64 pure ASCII bytes is skipped with a single test.
+     **************************************************************************/
+
+
+#ifdef CAP_UTF8_SSSE3
+
+
+    static constexpr uint8_t TOO_SHORT = 1 << 0;
+    static constexpr uint8_t TOO_LONG = 1 << 1;
+    static constexpr uint8_t OVERLONG_3 = 1 << 2;
+    static constexpr uint8_t TOO_LARGE = 1 << 3;
+    static constexpr uint8_t SURROGATE = 1 << 4;
+    static constexpr uint8_t OVERLONG_2 = 1 << 5;
+    static constexpr uint8_t TOO_LARGE_1000 = 1 << 6;
+    static constexpr uint8_t OVERLONG_4 = 1 << 6;
+    static constexpr uint8_t TWO_CONTS = 1 << 7;
+    static constexpr uint8_t CARRY = TOO_SHORT | TOO_LONG | TWO_CONTS;
+
+
+    #define CAP_U8(x) static_cast<char>(x)
+
+
+    //the errors of the 2-byte windows ending in each byte of input
+    CAP_TARGET_SSSE3 static __m128i check_block(__m128i input, __m128i previous) {
+        const __m128i byte1HighTable = _mm_setr_epi8(
+            //0_______ ________ <ASCII in byte 1>
+            CAP_U8(TOO_LONG), CAP_U8(TOO_LONG), CAP_U8(TOO_LONG), CAP_U8(TOO_LONG),
+            CAP_U8(TOO_LONG), CAP_U8(TOO_LONG), CAP_U8(TOO_LONG), CAP_U8(TOO_LONG),
+            //10______ ________ <continuation in byte 1>
+            CAP_U8(TWO_CONTS), CAP_U8(TWO_CONTS), CAP_U8(TWO_CONTS), CAP_U8(TWO_CONTS),
+            //1100____ ________ <two byte lead in byte 1>
+            CAP_U8(TOO_SHORT | OVERLONG_2),
+            //1101____ ________ <two byte lead in byte 1>
+            CAP_U8(TOO_SHORT),
+            //1110____ ________ <three byte lead in byte 1>
+            CAP_U8(TOO_SHORT | OVERLONG_3 | SURROGATE),
+            //1111____ ________ <four+ byte lead in byte 1>
+            CAP_U8(TOO_SHORT | TOO_LARGE | TOO_LARGE_1000 | OVERLONG_4));
+
+        const __m128i byte1LowTable = _mm_setr_epi8(
+            //____0000 ________
+            CAP_U8(CARRY | OVERLONG_3 | OVERLONG_2 | OVERLONG_4),
+            //____0001 ________
+            CAP_U8(CARRY | OVERLONG_2),
+            //____001_ ________
+            CAP_U8(CARRY),
+            CAP_U8(CARRY),
+            //____0100 ________
+            CAP_U8(CARRY | TOO_LARGE),
+            //____0101 ________
+            CAP_U8(CARRY | TOO_LARGE | TOO_LARGE_1000),
+            //____011_ ________
+            CAP_U8(CARRY | TOO_LARGE | TOO_LARGE_1000),
+            CAP_U8(CARRY | TOO_LARGE | TOO_LARGE_1000),
+            //____1___ ________
+            CAP_U8(CARRY | TOO_LARGE | TOO_LARGE_1000),
+            CAP_U8(CARRY | TOO_LARGE | TOO_LARGE_1000),
+            CAP_U8(CARRY | TOO_LARGE | TOO_LARGE_1000),
+            CAP_U8(CARRY | TOO_LARGE | TOO_LARGE_1000),
+            CAP_U8(CARRY | TOO_LARGE | TOO_LARGE_1000),
+            //____1101 ________
+            CAP_U8(CARRY | TOO_LARGE | TOO_LARGE_1000 | SURROGATE),
+            CAP_U8(CARRY | TOO_LARGE | TOO_LARGE_1000),
+            CAP_U8(CARRY | TOO_LARGE | TOO_LARGE_1000));
+
+        const __m128i byte2HighTable = _mm_setr_epi8(
+            //________ 0_______ <ASCII in byte 2>
+            CAP_U8(TOO_SHORT), CAP_U8(TOO_SHORT), CAP_U8(TOO_SHORT), CAP_U8(TOO_SHORT),
+            CAP_U8(TOO_SHORT), CAP_U8(TOO_SHORT), CAP_U8(TOO_SHORT), CAP_U8(TOO_SHORT),
+            //________ 1000____
+            CAP_U8(TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE_1000 | OVERLONG_4),
+            //________ 1001____
+            CAP_U8(TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE),
+            //________ 101_____
+            CAP_U8(TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE),
+            CAP_U8(TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE),
+            //________ 11______ <lead in byte 2>
+            CAP_U8(TOO_SHORT), CAP_U8(TOO_SHORT), CAP_U8(TOO_SHORT), CAP_U8(TOO_SHORT));
+
+        const __m128i lowNibble = _mm_set1_epi8(0x0F);
+
+        const __m128i previous1 = _mm_alignr_epi8(input, previous, 15);
+        const __m128i byte1High = _mm_shuffle_epi8(byte1HighTable, _mm_and_si128(_mm_srli_epi16(previous1, 4), lowNibble));
+        const __m128i byte1Low = _mm_shuffle_epi8(byte1LowTable, _mm_and_si128(previous1, lowNibble));
+        const __m128i byte2High = _mm_shuffle_epi8(byte2HighTable, _mm_and_si128(_mm_srli_epi16(input, 4), lowNibble));
+        const __m128i special = _mm_and_si128(_mm_and_si128(byte1High, byte1Low), byte2High);
+
+        //bytes that must be the 3rd or 4th of a sequence
+        const __m128i previous2 = _mm_alignr_epi8(input, previous, 14);
+        const __m128i previous3 = _mm_alignr_epi8(input, previous, 13);
+        const __m128i isThirdByte = _mm_subs_epu8(previous2, _mm_set1_epi8(CAP_U8(0xE0 - 0x80)));
+        const __m128i isFourthByte = _mm_subs_epu8(previous3, _mm_set1_epi8(CAP_U8(0xF0 - 0x80)));
+        const __m128i must23 = _mm_and_si128(_mm_or_si128(isThirdByte, isFourthByte), _mm_set1_epi8(CAP_U8(0x80)));
+
+        return _mm_xor_si128(must23, special);
+    }
+
+
+    //non-zero if the block ends in the middle of a sequence
+    CAP_TARGET_SSSE3 static __m128i incomplete_block(__m128i input) {
+        const __m128i maxValue = _mm_setr_epi8(
+            CAP_U8(0xFF), CAP_U8(0xFF), CAP_U8(0xFF), CAP_U8(0xFF), CAP_U8(0xFF), CAP_U8(0xFF), CAP_U8(0xFF), CAP_U8(0xFF),
+            CAP_U8(0xFF), CAP_U8(0xFF), CAP_U8(0xFF), CAP_U8(0xFF), CAP_U8(0xFF), CAP_U8(0xF0 - 1), CAP_U8(0xE0 - 1), CAP_U8(0xC0 - 1));
+        return _mm_subs_epu8(input, maxValue);
+    }
+
+
+    #undef CAP_U8
+
+
+    CAP_TARGET_SSSE3 static bool is_zero(__m128i value) {
+        return _mm_movemask_epi8(_mm_cmpeq_epi8(value, _mm_setzero_si128())) == 0xFFFF;
+    }
+
+
+    //vectorised search; the exact offset of an error is found by the scalar validator
+    CAP_TARGET_SSSE3 static size_t find_invalid_ssse3(const uint8_t* data, size_t size, bool& ascii) {
+        __m128i previous = _mm_setzero_si128();
+        __m128i previousIncomplete = _mm_setzero_si128();
+        size_t offset = 0;
+
+        for (; offset + 64 <= size; offset += 64) {
+            const __m128i input0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + offset));
+            const __m128i input1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + offset + 16));
+            const __m128i input2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + offset + 32));
+            const __m128i input3 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + offset + 48));
+            const __m128i any = _mm_or_si128(_mm_or_si128(input0, input1), _mm_or_si128(input2, input3));
+
+            __m128i error;
+
+            //ASCII fast path: only a sequence left open by the previous block can be an error
+            if (_mm_movemask_epi8(any) == 0) {
+                error = previousIncomplete;
+                previousIncomplete = _mm_setzero_si128();
+            }
+            else {
+                ascii = false;
+                error = check_block(input0, previous);
+                error = _mm_or_si128(error, check_block(input1, input0));
+                error = _mm_or_si128(error, check_block(input2, input1));
+                error = _mm_or_si128(error, check_block(input3, input2));
+                previousIncomplete = incomplete_block(input3);
+            }
+
+            if (!is_zero(error)) {
+                const size_t start = restart_offset(data, offset);
+                return start + find_invalid_scalar(data + start, size - start, ascii);
+            }
+
+            previous = input3;
+        }
+
+        //the tail, starting from the sequence left open by the last block
+        const size_t start = restart_offset(data, offset);
+        return start + find_invalid_scalar(data + start, size - start, ascii);
+    }
+
+
+    static bool has_ssse3() {
+#if defined(_MSC_VER)
+        int info[4];
+        __cpuid(info, 1);
+        return (info[2] & (1 << 9)) != 0;
+#else
+        return __builtin_cpu_supports("ssse3");
+#endif
+    }
+
+
+#endif //CAP_UTF8_SSSE3
+
+
+    /**************************************************************************
+       API
+     **************************************************************************/
+
+
+    //find invalid utf8
+    size_t find_invalid_utf8(const char* data, size_t size, bool& ascii) {
+        const uint8_t* bytes = reinterpret_cast<const uint8_t*>(data);
+#ifdef CAP_UTF8_SSSE3
+        static const bool ssse3 = has_ssse3();
+        if (ssse3) {
+            return find_invalid_ssse3(bytes, size, ascii);
+        }
+#endif
+        return find_invalid_scalar(bytes, size, ascii);
+    }
+
+
+    //validate utf8
+    bool validate_utf8(const std::string& input, Diagnostics& diagnostics, bool* ascii) {
+        const char* const data = input.data();
+        const size_t size = input.size();
+
+        bool allAscii = true;
+        bool valid = true;
+        size_t offset = 0;
+
+        //line tracking, advanced only when an error is found
+        int line = 1;
+        size_t lineStart = 0;
+        size_t scanned = 0;
+
+        while (offset < size) {
+            const size_t invalid = offset + find_invalid_utf8(data + offset, size - offset, allAscii);
+            if (invalid == size) {
+                break;
+            }
+
+            valid = false;
+            allAscii = false;
+
+            for (; scanned < invalid; ++scanned) {
+                if (data[scanned] == '\n') {
+                    ++line;
+                    lineStart = scanned + 1;
+                }
+            }
+
+            if (!diagnostics.report(DIAGNOSTIC::INVALID_UTF8, Position{ line, static_cast<int>(invalid - lineStart) + 1 }) && diagnostics.full()) {
+                break;
+            }
+
+            //resume after the maximal invalid prefix
+            char32_t codePoint;
+            bool sequenceValid;
+            offset = invalid + decode_utf8(data + invalid, size - invalid, codePoint, sequenceValid);
+        }
+
+        if (ascii) {
+            *ascii = allAscii;
+        }
+        return valid;
+    }
+
+
+} //namespace cap
@@ -0,0 +1,118 @@
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include "driver.hpp"
+
+using namespace std;
+using namespace cap;
+
+
+static void print_usage() {
+    std::cerr << "usage: capc [-j <jobs>] [--memory-stats] [--pipeline] [--references <name>]... [--manifest <file>]... <file>...\n";
+    std::cerr << "imported modules are parsed for diagnostics and references only; importers cannot use their enum constants\n";
+}
+
+
+int main(int argc, char* argv[]) {
+    BuildOptions options;
+    std::vector<std::string> files;
+    std::vector<std::string> names;
+    bool manifestsOk = true;
+
+    //parse the command line
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+
+        if (std::strcmp(arg, "-j") == 0 || std::strcmp(arg, "--jobs") == 0) {
+            if (++i == argc) {
+                print_usage();
+                return 2;
+            }
+            options.jobs = std::strtoul(argv[i], nullptr, 10);
+        }
+        else if (std::strncmp(arg, "-j", 2) == 0) {
+            options.jobs = std::strtoul(arg + 2, nullptr, 10);
+        }
+        else if (std::strcmp(arg, "--memory-stats") == 0) {
+            options.memoryStatistics = true;
+        }
+        else if (std::strcmp(arg, "--pipeline") == 0) {
+            options.pipeline = true;
+        }
+        else if (std::strcmp(arg, "--references") == 0) {
+            if (++i == argc) {
+                print_usage();
+                return 2;
+            }
+            names.push_back(argv[i]);
+            options.crossReferences = true;
+        }
+        else if (std::strcmp(arg, "--manifest") == 0) {
+            if (++i == argc) {
+                print_usage();
+                return 2;
+            }
+            if (!load_manifest(argv[i], files)) {
+                std::cerr << argv[i] << ": error: cannot read manifest\n";
+                manifestsOk = false;
+            }
+        }
+        else if (arg[0] == '-') {
+            print_usage();
+            return 2;
+        }
+        else {
+            files.push_back(arg);
+        }
+    }
+
+    if (files.empty() && manifestsOk) {
+        print_usage();
+        return 2;
+    }
+
+    //build
+    const BuildResult result = build(files, options);
+
+    //report
+    for (const Diagnostic& diagnostic : result.diagnostics) {
+        std::cerr << result.files[diagnostic.file] << ':' << diagnostic.position.line << ':' << diagnostic.position.column << ": error: " << result.diagnostics.format(diagnostic) << '\n';
+    }
+    if (result.diagnostics.dropped() > 0) {
+        std::cerr << result.diagnostics.dropped() << " further errors not shown\n";
+    }
+
+    const BuildStatistics& stats = result.statistics;
+    const double seconds = stats.seconds > 0 ? stats.seconds : 1e-9;
+    std::cout << stats.files << " files, "
+              << stats.bytes << " bytes, "
+              << stats.tokens << " tokens, "
+              << stats.declarations << " declarations, "
+              << stats.modules << " imported modules in "
+              << stats.seconds << " s with " << stats.jobs << " jobs ("
+              << stats.files / seconds << " files/s, "
+              << stats.bytes / seconds / (1024 * 1024) << " MB/s, "
+              << stats.tokens / seconds << " tokens/s)\n";
+
+    //definitions and references of the requested names
+    for (const std::string& name : names) {
+        const CrossReferenceIndex::Symbol* symbol = result.crossReferences.find(name);
+        if (!symbol) {
+            std::cout << name << ": not found\n";
+            continue;
+        }
+        for (const Location& location : symbol->definitions) {
+            std::cout << result.files[location.file] << ':' << location.position.line << ':' << location.position.column << ": definition of " << name << '\n';
+        }
+        for (const Location& location : symbol->references) {
+            std::cout << result.files[location.file] << ':' << location.position.line << ':' << location.position.column << ": reference to " << name << '\n';
+        }
+    }
+
+    if (options.memoryStatistics) {
+        std::cout << "memory:\n";
+        result.memory.print(std::cout);
+    }
+
+    return result.diagnostics.empty() && manifestsOk ? 0 : 1;
+}